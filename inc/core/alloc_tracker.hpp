@@ -0,0 +1,151 @@
+#ifndef ALLOC_TRACKER_HPP_
+#define ALLOC_TRACKER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+namespace gearshifft {
+
+  /**
+   * Heap allocations during planning, execution and destroy (--track-allocs).
+   *
+   * The counters are fed by the malloc interposition of src/alloc_hook.cpp
+   * (glibc, compiled in with GEARSHIFFT_ALLOC_HOOK), which forwards all calls
+   * to the C library and only counts while a scope is active.  Bytes are the
+   * usable sizes of the blocks, the net bytes are allocated minus freed bytes
+   * of the scope.  Allocations of all threads are counted, including threads
+   * of the FFT library, so there is only one scope at a time (not with --streams).
+   * Without the hook the records are NaN.
+   */
+  class AllocTracker {
+  public:
+    struct Counts {
+      double allocations = 0.0;
+      double bytes = 0.0;
+    };
+
+    static void enable(bool enabled) {
+      enabled_() = enabled;
+      if(enabled && !isHooked())
+        std::cerr << "gearshifft: allocation tracking not available (built without GEARSHIFFT_ALLOC_HOOK or not glibc).\n";
+    }
+
+    static bool isEnabled() {
+      return enabled_();
+    }
+
+    /// true if the malloc interposition is linked
+    static bool isHooked() {
+      return state().hooked.load(std::memory_order_relaxed);
+    }
+
+    /// resets the counters and starts counting
+    static void start() {
+      if(!isEnabled())
+        return;
+      State& s = state();
+      s.allocations.store(0, std::memory_order_relaxed);
+      s.allocated.store(0, std::memory_order_relaxed);
+      s.freed.store(0, std::memory_order_relaxed);
+      s.active.store(true, std::memory_order_release);
+    }
+
+    /// stops counting, returns allocations and net bytes since start() (NaN without hook)
+    static Counts stop() {
+      Counts counts;
+      if(!isEnabled())
+        return counts;
+      State& s = state();
+      s.active.store(false, std::memory_order_release);
+      s.paused.store(false, std::memory_order_relaxed);
+      if(!isHooked()) {
+        counts.allocations = counts.bytes = std::numeric_limits<double>::quiet_NaN();
+        return counts;
+      }
+      counts.allocations = static_cast<double>(s.allocations.load(std::memory_order_relaxed));
+      counts.bytes = static_cast<double>(s.allocated.load(std::memory_order_relaxed))
+        - static_cast<double>(s.freed.load(std::memory_order_relaxed));
+      return counts;
+    }
+
+    /// suspends counting between start() and stop(), e.g. for untimed work of a timed step
+    static void pause() {
+      if(!isEnabled())
+        return;
+      State& s = state();
+      s.paused.store(s.active.exchange(false, std::memory_order_acq_rel), std::memory_order_relaxed);
+    }
+
+    /// continues counting after pause()
+    static void resume() {
+      if(!isEnabled())
+        return;
+      State& s = state();
+      if(s.paused.exchange(false, std::memory_order_relaxed))
+        s.active.store(true, std::memory_order_release);
+    }
+
+    /// called by the hook
+    static void allocated(size_t bytes) {
+      State& s = state();
+      if(!s.active.load(std::memory_order_relaxed))
+        return;
+      s.allocations.fetch_add(1, std::memory_order_relaxed);
+      s.allocated.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /// called by the hook
+    static void freed(size_t bytes) {
+      State& s = state();
+      if(!s.active.load(std::memory_order_relaxed))
+        return;
+      s.freed.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    /// called by the hook
+    static bool isActive() {
+      return state().active.load(std::memory_order_relaxed);
+    }
+
+    /// called by the hook once it is linked
+    static void setHooked() {
+      state().hooked.store(true, std::memory_order_relaxed);
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      if(isEnabled())
+        msg << ",\"AllocHook\"," << isHooked();
+      return msg.str();
+    }
+
+  private:
+    /// constant initialized, so the hook may use it before static initialization
+    struct State {
+      std::atomic<bool> hooked{false};
+      std::atomic<bool> active{false};
+      std::atomic<bool> paused{false};
+      std::atomic<uint64_t> allocations{0};
+      std::atomic<uint64_t> allocated{0};
+      std::atomic<uint64_t> freed{0};
+    };
+
+    static State& state() {
+      static State s;
+      return s;
+    }
+
+    static bool& enabled_() {
+      static bool enabled = false;
+      return enabled;
+    }
+  };
+
+} // gearshifft
+
+#endif /* ALLOC_TRACKER_HPP_ */
@@ -1,10 +1,20 @@
 #ifndef APPLICATION_HPP_
 #define APPLICATION_HPP_
 
+#include "alloc_tracker.hpp"
+#include "buffer_ring.hpp"
+#include "cache_flush.hpp"
+#include "cpu_placement.hpp"
+#include "data_pattern.hpp"
+#include "huge_pages.hpp"
+#include "memory_usage.hpp"
+#include "os_noise.hpp"
+#include "perf_counters.hpp"
 #include "result_benchmark.hpp"
 #include "result_all.hpp"
 #include "timer_cpu.hpp"
 #include "types.hpp"
+#include "validation.hpp"
 
 #include "gearshifft_version.hpp"
 
@@ -20,18 +30,6 @@
 #include <sstream>
 
 
-#ifndef GEARSHIFFT_NUMBER_WARM_RUNS
-#define GEARSHIFFT_NUMBER_WARM_RUNS 10
-#endif
-
-#ifndef GEARSHIFFT_NUMBER_WARMUPS
-#define GEARSHIFFT_NUMBER_WARMUPS 2
-#endif
-
-#ifndef GEARSHIFFT_NUMBER_RUNS
-#define GEARSHIFFT_NUMBER_RUNS GEARSHIFFT_NUMBER_WARM_RUNS + GEARSHIFFT_NUMBER_WARMUPS
-#endif
-
 #ifndef GEARSHIFFT_ERROR_BOUND
 #define GEARSHIFFT_ERROR_BOUND 0.00001
 #endif
@@ -45,15 +43,12 @@ namespace gearshifft {
   template<typename T_Context>
   class Application {
   public:
-    /// Number of benchmark runs after warmup
-    static constexpr int NR_RUNS = GEARSHIFFT_NUMBER_RUNS;
-    static constexpr int NR_WARM_RUNS = GEARSHIFFT_NUMBER_WARM_RUNS;
-    static constexpr int NR_WARMUP_RUNS = GEARSHIFFT_NUMBER_WARMUPS;
+    /// Number of benchmark runs are set at runtime, see OptionsDefault::getNumberRuns()
     static constexpr int NR_RECORDS  = static_cast<int>(RecordType::NrRecords_);
     static constexpr int DUMP_FREQUENCY = GEARSHIFFT_DUMP_FREQUENCY;
-    using ResultAllT    = ResultAll<NR_RUNS, NR_WARMUP_RUNS, NR_RECORDS>;
-    using ResultWriterT = ResultWriter<NR_RUNS, NR_WARMUP_RUNS, NR_RECORDS>;
-    using ResultT       = ResultBenchmark<NR_RUNS, NR_RECORDS>;
+    using ResultAllT    = ResultAll<NR_RECORDS>;
+    using ResultWriterT = ResultWriter<NR_RECORDS>;
+    using ResultT       = ResultBenchmark<NR_RECORDS>;
     /// Boost tests will fail when deviation(iFFT(FFT(data)),data) returns a greater value
     static constexpr double ERROR_BOUND = GEARSHIFFT_ERROR_BOUND;
 
@@ -66,7 +61,9 @@ namespace gearshifft {
       return context_created_;
     }
 
+    /// calibrates the timer (--timer) and creates the context
     void createContext() {
+      TSC::configure(T_Context::options().getTimer()=="tsc");
       TimerCPU timer;
       timer.startTimer();
       context_.create();
@@ -95,10 +92,32 @@ namespace gearshifft {
       std::time_t now = std::time(nullptr);
       std::stringstream meta_information;
       meta_information << context_.get_used_device_properties()
-                       << ",\"NumberWarmups\"," << NR_WARMUP_RUNS
-                       << ",\"NumberWarmRuns\"," << NR_WARM_RUNS
-                       << ",\"NumberTotalRuns\"," << NR_RUNS
-                       << ",\"ErrorBound\"," << ERROR_BOUND
+                       << ",\"NumberWarmups\"," << T_Context::options().getNumberWarmups()
+                       << ",\"NumberWarmRuns\"," << T_Context::options().getNumberWarmRuns()
+                       << ",\"NumberTotalRuns\"," << T_Context::options().getNumberRuns()
+                       << ",\"SteadyState\"," << T_Context::options().getSteadyState()
+                       << ",\"LatencySamples\"," << T_Context::options().getLatencySamples()
+                       << ",\"InnerTime [ms]\"," << T_Context::options().getInnerTime();
+      if(T_Context::options().isAdaptive()) {
+        // number of runs and warmups above are not used
+        meta_information << ",\"TargetCI\"," << T_Context::options().getTargetCI()
+                         << ",\"MaxRuns\"," << T_Context::options().getMaxRuns()
+                         << ",\"MaxTime [s]\"," << T_Context::options().getMaxTime();
+      }
+      meta_information << TSC::properties()
+                       << CacheFlush::properties()
+                       << CpuPlacement::get().properties();
+      if(T_Context::options().isHugePagesReported())
+        meta_information << HugePages::properties();
+      meta_information << BufferRing::properties()
+                       << Validation::properties()
+                       << DataPattern::properties()
+                       << Denormals::properties()
+                       << PerfCounters::properties()
+                       << MemoryUsage::properties()
+                       << OsNoise::properties()
+                       << AllocTracker::properties();
+      meta_information << ",\"ErrorBound\"," << ERROR_BOUND
                        << ",\"CurrentTime\"," << now
                        << ",\"CurrentTimeLocal\",\"" << strtok(ctime(&now), "\n") << "\""
                        << ",\"Hostname\",\"" << boost::asio::ip::host_name() << "\""
@@ -109,6 +128,7 @@ namespace gearshifft {
                           T_Context::options().getOutputFile(),
                           T_Context::title(),
                           meta_information.str(),
+                          activeRecords(),
                           T_Context::options().getVerbose());
     }
 
@@ -116,6 +136,72 @@ namespace gearshifft {
       resultWriter_.stop(timeContextCreate_, timeContextDestroy_);
     }
 
+    /// records of all record groups enabled by program options
+    static std::vector<RecordType> activeRecords() {
+      std::vector<RecordType> records;
+      for(int ival=0; ival<NR_RECORDS; ++ival) {
+        auto record = static_cast<RecordType>(ival);
+        switch(recordGroup(record)) {
+        case RecordGroup::Default:
+          records.push_back(record);
+          break;
+        case RecordGroup::SteadyState:
+          if(T_Context::options().getSteadyState() || T_Context::options().isStreamsMode())
+            records.push_back(record);
+          break;
+        case RecordGroup::Streams:
+          if(T_Context::options().isStreamsMode())
+            records.push_back(record);
+          break;
+        case RecordGroup::Latency:
+          if(T_Context::options().getLatencySamples() > 0)
+            records.push_back(record);
+          break;
+        case RecordGroup::PerfCounters:
+          if(T_Context::options().getPerfCounters())
+            records.push_back(record);
+          break;
+        case RecordGroup::Flush:
+          if(T_Context::options().getFlushCache())
+            records.push_back(record);
+          break;
+        case RecordGroup::HugePages:
+          if(T_Context::options().isHugePagesReported())
+            records.push_back(record);
+          break;
+        case RecordGroup::InnerRepetition:
+          if(T_Context::options().getInnerTime() > 0.0)
+            records.push_back(record);
+          break;
+        case RecordGroup::Validation:
+          if(T_Context::options().getValidate()!="every")
+            records.push_back(record);
+          break;
+        case RecordGroup::Allocations:
+          if(T_Context::options().getTrackAllocs())
+            records.push_back(record);
+          break;
+        case RecordGroup::WisdomCache:
+          if(!T_Context::options().getWisdomCache().empty())
+            records.push_back(record);
+          break;
+        case RecordGroup::OsNoise:
+          if(T_Context::options().getOsNoise())
+            records.push_back(record);
+          break;
+        case RecordGroup::Memory:
+          if(T_Context::options().getMemory())
+            records.push_back(record);
+          break;
+        case RecordGroup::BufferRing:
+          if(T_Context::options().getBufferRing()!="off")
+            records.push_back(record);
+          break;
+        }
+      }
+      return records;
+    }
+
   private:
     T_Context context_;
     bool context_created_ = false;
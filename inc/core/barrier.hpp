@@ -0,0 +1,42 @@
+#ifndef BARRIER_HPP_
+#define BARRIER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+namespace gearshifft {
+
+  /**
+   * Reusable thread barrier, wait() returns when count threads are waiting.
+   */
+  class Barrier {
+  public:
+    explicit Barrier(size_t count) : count_(count) {}
+
+    Barrier(const Barrier&) = delete;
+    Barrier& operator=(const Barrier&) = delete;
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(mutex_);
+      size_t generation = generation_;
+      if(++waiting_ == count_) {
+        ++generation_;
+        waiting_ = 0;
+        cv_.notify_all();
+      } else {
+        cv_.wait(lock, [&](){ return generation != generation_; });
+      }
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+  };
+
+} // gearshifft
+
+#endif /* BARRIER_HPP_ */
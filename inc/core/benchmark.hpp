@@ -4,8 +4,20 @@
 #define BOOST_TEST_NO_MAIN
 #define BOOST_TEST_ALTERNATIVE_INIT_API
 
+#include "alloc_tracker.hpp"
 #include "application.hpp"
+#include "buffer_ring.hpp"
+#include "cache_flush.hpp"
 #include "benchmark_suite.hpp"
+#include "cpu_placement.hpp"
+#include "data_pattern.hpp"
+#include "huge_pages.hpp"
+#include "inner_repetition.hpp"
+#include "latency_histogram.hpp"
+#include "memory_usage.hpp"
+#include "os_noise.hpp"
+#include "perf_counters.hpp"
+#include "validation.hpp"
 #include "gearshifft_version.hpp"
 
 // see https://www.boost.org/doc/libs/1_65_1/libs/test/doc/html/boost_test/usage_variants.html
@@ -62,10 +74,34 @@ namespace gearshifft {
         return 0;
       }
 
+      CpuPlacement::get().configure(Context::options().getNumaPolicy(),
+                                    Context::options().getPin());
+      HugePages::configure(Context::options().getHugePages(),
+                           Context::options().isHugePagesReported());
+      CacheFlush::enable(Context::options().getFlushCache());
+      BufferRing::configure(Context::options().getBufferRing());
+      PerfCounters::enable(Context::options().getPerfCounters());
+      MemoryUsage::enable(Context::options().getMemory());
+      AllocTracker::enable(Context::options().getTrackAllocs());
+      OsNoise::enable(Context::options().getOsNoise(),
+                      Context::options().getNoiseThreshold());
+      LatencySampler::enable(Context::options().getLatencySamples());
+      InnerRepetition::enable(Context::options().getInnerTime());
+      Validation::configure(Context::options().getValidate(),
+                            Context::options().isAdaptive());
+      DataPattern::configure(Context::options().getData(),
+                             Context::options().getSeed());
+      Denormals::configure(Context::options().getFTZ(),
+                           Context::options().getDAZ());
+      if(!Context::options().getListBenchmarks()) {
+        LatencySampler::open(Context::options().getLatencyHistogramFile());
+      }
       AppT::getInstance().createContext();
       if (!Context::options().getListBenchmarks()) {
         AppT::getInstance().startWriter();
       }
+      // after the writer thread, before the FFT library creates its threads (they inherit the counters)
+      PerfCounters::get().open();
 
       auto init_function = []() {
         BenchmarkSuite<Context, T_FFT_Is_Normalized, T_FFTs, T_Precisions> instance;
@@ -1,20 +1,23 @@
 #ifndef BENCHMARK_DATA_HPP_
 #define BENCHMARK_DATA_HPP_
 
+#include "data_pattern.hpp"
+#include "huge_pages.hpp"
 #include "types.hpp"
 
-// http://www.boost.org/doc/libs/1_56_0/doc/html/align/tutorial.html
-
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
 #pragma GCC diagnostic ignored "-Wunused-parameter"
-#include <boost/align/aligned_allocator.hpp>
 #include <boost/range/counting_range.hpp>
 #include <boost/container/vector.hpp>
 #include <boost/noncopyable.hpp>
 #pragma GCC diagnostic pop
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <thread>
 #include <vector>
 #include <cmath>
 
@@ -22,8 +25,15 @@ namespace gearshifft {
 
 /**
  * Singleton test data helper and container.
- * Creates real and complex data on first access or when dimensions have changed.
- * Provides check_deviation() for accuracy comparison.
+ * Creates real and complex data on first access or when dimensions or batch have changed,
+ * the signal is selected by DataPattern and generated in parallel.
+ * Batched data holds `batch` consecutive signals of the given extents.
+ * Provides check_deviation() for accuracy comparison, which runs in parallel
+ * over chunks of CHECK_CHUNK elements (OpenMP if enabled, std::thread otherwise).
+ * The squared differences are summed per chunk (vectorized), the chunk sums
+ * pairwise, so the result does not depend on the number of threads.
+ * The input is kept as pristine real and complex copy (the latter created
+ * on first use), copyTo() restores a buffer with a parallel bulk copy.
  * \note FFT works with accuracy like O(eps*log(N)).
  * \note max(data)-min(data) should fit into realtypes precision.
  */
@@ -33,56 +43,177 @@ namespace gearshifft {
     using ComplexType    = Real2D<RealType>;
     using BenchmarkDataT = BenchmarkData<RealType, Dimensions>;
     using Extent         = std::array<size_t, Dimensions>;
-    using RealVector     = std::vector<RealType, boost::alignment::
-                                       aligned_allocator<RealType,
-                                                         alignof(RealType)> >;
-    using ComplexVector  = std::vector<ComplexType, boost::alignment::
-                                       aligned_allocator<ComplexType,
-                                                         alignof(ComplexType)> >;
+    using RealVector     = std::vector<RealType, HugePageAllocator<RealType> >;
+    using ComplexVector  = std::vector<ComplexType, HugePageAllocator<ComplexType> >;
 
 
-    static const BenchmarkDataT& data(const Extent& extents) {
+    static const BenchmarkDataT& data(const Extent& extents, size_t batch = 1) {
       static BenchmarkDataT data;
-      data.init_if_dim_changed(extents);
+      data.init_if_dim_changed(extents, batch);
       return data;
     }
 
+    /// number of elements of a single signal
     size_t size() const {
       return size_;
     }
 
+    /// number of elements of all signals in the batch
+    size_t total() const {
+      return total_;
+    }
+
     void copyTo(RealVector& vec) const {
-      vec.resize(size_);
-      std::copy(data_linear_.begin(), data_linear_.end(), vec.begin());
+      vec.resize(total_);
+      bulk_copy(data_linear_, vec);
     }
 
     void copyTo(ComplexVector& vec) const {
-      vec.resize(size_);
-      for( size_t i=0; i<size_; ++i ){
-        vec[i].real(data_linear_[i]);
-        vec[i].imag(0.0);
-      }
+      vec.resize(total_);
+      bulk_copy(data_complex(), vec);
     }
 
+    /// elements per chunk of copyTo()
+    static constexpr size_t COPY_CHUNK = 1<<16;
+
+    /// elements per chunk of check_deviation()
+    static constexpr size_t CHECK_CHUNK = 4096;
+
     // deviation = sample standard deviation
+    // stride > 1 compares every stride-th element only
+    // a single compared element (stride >= total) reports its absolute difference
     template<bool Normalize, typename TVector>
     void check_deviation(double& deviation,
                          size_t& mismatches,
                          const TVector& data,
-                         double error_bound) const {
+                         double error_bound,
+                         size_t stride = 1) const {
+      const size_t n = (total_ + stride - 1) / stride;
+      const size_t nchunks = (n + CHECK_CHUNK - 1) / CHECK_CHUNK;
+      std::vector<double> sums(nchunks, 0.0);
+      std::vector<size_t> counts(nchunks, 0);
+      parallel_for(nchunks, [&](size_t c) {
+          const size_t begin = c * CHECK_CHUNK;
+          const size_t end = std::min(n, begin + CHECK_CHUNK);
+          double sum = 0.0;
+          size_t count = 0;
+#ifdef _OPENMP
+#pragma omp simd reduction(+:sum,count)
+#endif
+          for( size_t j=begin; j<end; ++j ){
+            double diff = sub<Normalize>(data, j*stride);
+            count += !(diff <= error_bound); // includes nan
+            sum += diff*diff;
+          }
+          sums[c] = sum;
+          counts[c] = count;
+        });
+      mismatches += std::accumulate(counts.begin(), counts.end(), size_t(0));
+      const double dof = n > 1 ? n-1.0 : 1.0;
+      deviation = sqrt(pairwise_sum(sums.data(), nchunks)/dof);
+    }
+
+    /// number of NaN and Inf values in data (checks runs and elements which are not compared)
+    template<typename TVector>
+    size_t count_nonfinite(const TVector& data) const {
+      const size_t nchunks = (total_ + CHECK_CHUNK - 1) / CHECK_CHUNK;
+      std::vector<size_t> counts(nchunks, 0);
+      parallel_for(nchunks, [&](size_t c) {
+          const size_t begin = c * CHECK_CHUNK;
+          const size_t end = std::min(total_, begin + CHECK_CHUNK);
+          size_t count = 0;
+#ifdef _OPENMP
+#pragma omp simd reduction(+:count)
+#endif
+          for( size_t i=begin; i<end; ++i )
+            count += !(magnitude(data, i) <= std::numeric_limits<double>::max());
+          counts[c] = count;
+        });
+      return std::accumulate(counts.begin(), counts.end(), size_t(0));
+    }
+
+    /// sequential reference of check_deviation()
+    template<bool Normalize, typename TVector>
+    void check_deviation_serial(double& deviation,
+                                size_t& mismatches,
+                                const TVector& data,
+                                double error_bound) const {
       double diff_sum = 0;
       double diff;
-      for( size_t i=0; i<size_; ++i ){
+      for( size_t i=0; i<total_; ++i ){
         diff = sub<Normalize>(data, i);
         if(std::isnan(diff) || diff > error_bound)
           ++mismatches;
         diff_sum += diff*diff;
       }
-      deviation = sqrt(diff_sum/(size_-1.0));
+      deviation = sqrt(diff_sum/(total_-1.0));
     }
 
   private:
 
+    template<typename TVector>
+    static void bulk_copy(const TVector& src, TVector& dst) {
+      const size_t n = src.size();
+      parallel_for((n + COPY_CHUNK - 1) / COPY_CHUNK, [&](size_t c) {
+          const size_t begin = c * COPY_CHUNK;
+          const size_t end = std::min(n, begin + COPY_CHUNK);
+          std::copy(src.begin() + begin, src.begin() + end, dst.begin() + begin);
+        });
+    }
+
+    /// complex copy of the input, created on first use (concurrent streams may call copyTo())
+    const ComplexVector& data_complex() const {
+      std::lock_guard<std::mutex> lock(mutex_complex_);
+      if(data_complex_.size() != total_) {
+        data_complex_.resize(total_);
+        for( size_t i=0; i<total_; ++i ){
+          data_complex_[i].real(data_linear_[i]);
+          data_complex_[i].imag(0.0);
+        }
+      }
+      return data_complex_;
+    }
+
+    static double pairwise_sum(const double* values, size_t n) {
+      if(n <= 8) {
+        double sum = 0.0;
+        for( size_t i=0; i<n; ++i )
+          sum += values[i];
+        return sum;
+      }
+      return pairwise_sum(values, n/2) + pairwise_sum(values + n/2, n - n/2);
+    }
+
+    /// calls f(i) for i in [0,n) in parallel
+    template<typename TFunction>
+    static void parallel_for(size_t n, TFunction&& f) {
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) if(n > 1)
+      for( size_t i=0; i<n; ++i )
+        f(i);
+#else
+      const size_t nthreads = std::min<size_t>(n, std::max(1u, std::thread::hardware_concurrency()));
+      std::vector<std::thread> threads;
+      for( size_t t=1; t<nthreads; ++t )
+        threads.emplace_back([&, t]() {
+            for( size_t i=t; i<n; i+=nthreads )
+              f(i);
+          });
+      for( size_t i=0; i<n; i+=nthreads )
+        f(i);
+      for( auto& thread : threads )
+        thread.join();
+#endif
+    }
+
+    static double magnitude(const ComplexVector& vector, size_t i) {
+      return std::abs(static_cast<double>(vector[i].real())) + std::abs(static_cast<double>(vector[i].imag()));
+    }
+
+    static double magnitude(const RealVector& vector, size_t i) {
+      return std::abs(static_cast<double>(vector[i]));
+    }
+
     template<bool Normalize>
     constexpr double sub(const ComplexVector& vector, size_t i) const {
       return Normalize ? 1.0/size_ * (vector[i].real()) - static_cast<double>(data_linear_[i]) : static_cast<double>( vector[i].real() - data_linear_[i] );
@@ -93,14 +224,18 @@ namespace gearshifft {
       return Normalize ? 1.0/size_ * (vector[i]) - static_cast<double>(data_linear_[i]) : static_cast<double>( vector[i] - data_linear_[i] );
     }
 
-    void init_if_dim_changed(const Extent& extents) {
-      if(extents_ == extents) // nothing changed
+    void init_if_dim_changed(const Extent& extents, size_t batch) {
+      if(extents_ == extents && batch_ == batch) // nothing changed
         return;
       extents_ = extents;
+      batch_ = batch;
       size_ = std::accumulate(extents_.begin(), extents_.end(), 1, std::multiplies<size_t>());
+      total_ = size_ * batch_;
 
       // allocate variables for all test cases
-      data_linear_.resize(size_);
+      data_linear_.resize(total_);
+      data_complex_.clear();
+      data_complex_.shrink_to_fit();
 
       const size_t limit16 = 1<<15;
       if(std::is_same<RealType, float16>::value && size_ > limit16) {
@@ -108,18 +243,22 @@ namespace gearshifft {
         // (y[0] of FFT(x) is sum of input values)
         // Overflow leads to nan or inf values and iFFT(FFT()) cannot be validated
         // This method still leads to nan's when size_ >= (1<<20)
-        for( size_t i=0; i<size_; ++i )
+        // The non-zero points hold the data pattern of a limit16 signal scaled by 0.1
+        const size_t stride = size_/limit16;
+        for( size_t i=0; i<total_; ++i )
         {
-          if( i%(size_/limit16)==0 )
-            data_linear_[i] = 0.1;
+          const size_t k = i%size_;
+          if( k%stride==0 )
+            data_linear_[i] = 0.1 * DataPattern::value<RealType>((i/size_)*limit16 + k/stride, limit16);
           else
             data_linear_[i] = 0.0;
         }
       } else {
-        for( size_t i=0; i<size_; ++i )
-        {
-          data_linear_[i] = 0.125*(i&7);
-        }
+        parallel_for((total_ + COPY_CHUNK - 1) / COPY_CHUNK, [&](size_t c) {
+            const size_t end = std::min(total_, (c+1) * COPY_CHUNK);
+            for( size_t i=c*COPY_CHUNK; i<end; ++i )
+              data_linear_[i] = DataPattern::value<RealType>(i, size_);
+          });
       }
 
     }
@@ -129,8 +268,12 @@ namespace gearshifft {
 
   private:
     RealVector data_linear_;
+    mutable ComplexVector data_complex_;
+    mutable std::mutex mutex_complex_;
     Extent extents_ = {{0}};
+    size_t batch_ = 0;
     size_t size_ = 0;
+    size_t total_ = 0;
 
   };
 } // gearshifft
@@ -4,8 +4,14 @@
 #define BOOST_TEST_ALTERNATIVE_INIT_API
 
 #include "application.hpp"
+#include "barrier.hpp"
 #include "benchmark_data.hpp"
+#include "cpu_placement.hpp"
+#include "inner_repetition.hpp"
+#include "latency_histogram.hpp"
+#include "statistics.hpp"
 #include "types.hpp"
+#include "validation.hpp"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wold-style-cast"
@@ -13,12 +19,26 @@
 #include <boost/test/included/unit_test.hpp> // Single-header usage variant
 #pragma GCC diagnostic pop
 
-#include <type_traits>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace gearshifft {
   /**
-   * Benchmark body with NR_RUNS repetitions of iFFT(FFT()) implementation.
+   * Benchmark body with repetitions of iFFT(FFT()) implementation
+   * (number of runs and warmups given by program options).
+   * In adaptive mode (--target-ci) runs are repeated until the confidence
+   * interval of FFT and iFFT times converges, see AdaptiveRepetition.
+   * In steady-state mode (--steady-state) client and plans are kept across runs, see FFT::steady().
+   * With --streams several FFT streams run concurrently, see Streams.
+   * Each benchmark runs a batch of transforms of the same extents.
    * Implementation is given with TFunctor.
    * Depending on TFunctor::InputIsReal it uses RealType or ComplexType test data.
    * FFT output will be [normalized and] compared to original input.
@@ -32,7 +52,6 @@ namespace gearshifft {
   struct BenchmarkExecutor {
     using ApplicationT = Application<T_Context>;
     using ResultT = typename ApplicationT::ResultT;
-    static constexpr int NR_RUNS = ApplicationT::NR_RUNS; // includes warmups
     static constexpr double ERROR_BOUND = ApplicationT::ERROR_BOUND;
     static constexpr size_t NDim = std::tuple_size<T_Extents>::value;
     using VectorT = typename std::conditional<T_FFT_Wrapper::IsComplex,
@@ -40,48 +59,73 @@ namespace gearshifft {
                                               typename BenchmarkData<T_Precision,NDim>::RealVector>::type;
     static_assert(NDim<=3,"NDim<=3");
 
-    void operator()(const T_Extents& extents) {
-      const auto& dataset = BenchmarkData<T_Precision,NDim>::data(extents);
-
-      VectorT data_buffer;
-      dataset.copyTo(data_buffer);
-      assert(data_buffer.data());
+    void operator()(const T_Extents& extents, const BenchmarkConfig& config) {
+      const size_t batch = config.batch;
+      const auto& dataset = BenchmarkData<T_Precision,NDim>::data(extents, batch);
 
-      auto fft = T_FFT_Wrapper();
+      auto& options = T_Context::options();
+      // clients read the number of threads and the planner in their constructor
+      options.setNumberDevices(config.ndevices);
+      options.setPlanner(config.planner);
+      const bool adaptive = options.isAdaptive();
+      const bool steady_state = options.getSteadyState();
+      // includes warmups, upper limit in adaptive mode
+      const int nruns = adaptive ? options.getMaxRuns() : options.getNumberRuns();
+      const double error_bound = ERROR_BOUND<0.0 ? ErrorBound<T_Precision>()() : ERROR_BOUND;
       ResultT result;
       result.template init<T_FFT_Wrapper::IsComplex,
                            T_FFT_Wrapper::IsInplace,
                            T_Precision >
-                       (extents);
+                       (extents, config, nruns, adaptive ? 0 : options.getNumberWarmups());
+      AdaptiveRepetition repetition(options.getTargetCI(),
+                                    options.getMaxRuns(),
+                                    options.getMaxTime());
 
-      int r;
+      int r = 0;
       try {
-        const double error_bound = ERROR_BOUND<0.0 ? ErrorBound<T_Precision>()() : ERROR_BOUND;
-        for(r = 0; r < NR_RUNS; ++r)
-        {
-          result.setRun(r);
+        if(options.isStreamsMode()) {
+          Streams streams(result, dataset, extents, config, error_bound, nruns);
+          for(r = 0; r < nruns; ++r)
+          {
+            result.setRun(r);
+            streams.run(result);
+            check(result, r, error_bound);
+            if( adaptive && !next(result, repetition) )
+              break;
+          }
+          // destroy time is added to the last run
+          result.setRun(result.getNumberRuns()-1);
+          streams.finish(&result);
+        } else {
+          VectorT data_buffer;
           dataset.copyTo(data_buffer);
-          fft(result, data_buffer, extents);
-
-          double deviation = 0.0; // sample standard deviation
-          size_t mismatches = 0; // nr of mismatches
-          // compute deviation and mismatches
-          dataset.template check_deviation<!T_FFT_Normalized::value>
-            (deviation, mismatches, data_buffer, error_bound);
-
-          result.setValue(RecordType::Deviation, deviation);
-          result.setValue(RecordType::Mismatches, static_cast<double>(mismatches));
-
-          if(std::isnan(deviation) || deviation>error_bound) {
-            std::stringstream msg;
-            msg << "mismatches=" << mismatches
-                << " deviation=" << deviation
-                << " errorbound=" << error_bound;
-            result.setError(r, msg.str());
-            throw std::runtime_error(msg.str());
+          assert(data_buffer.data());
+          auto fft = T_FFT_Wrapper();
+
+          for(r = 0; r < nruns; ++r)
+          {
+            result.setRun(r);
+            dataset.copyTo(data_buffer);
+            if(steady_state)
+              fft.steady(result, data_buffer, extents, batch);
+            else
+              fft(result, data_buffer, extents, batch);
+
+            validate(result, dataset, data_buffer, error_bound, r, nruns);
+            if(LatencySampler::getSamples() > 0)
+              LatencySampler::get().dump(result.getID(), r);
+            check(result, r, error_bound);
+
+            if( adaptive && !next(result, repetition) )
+              break;
           }
+          // destroy time (steady-state) and wisdom export are added to the last run
+          result.setRun(result.getNumberRuns()-1);
+          fft.teardown(result);
         }
       } catch(const std::runtime_error& e) {
+        if(adaptive) // runs after the failed one are not executed
+          result.setNumberRuns(r+1, std::min(r+1, repetition.getNumberWarmups()));
         result.setError(r, e.what());
         ApplicationT::getInstance().addRecord(result);
         BOOST_FAIL( e.what() );
@@ -89,6 +133,281 @@ namespace gearshifft {
 
       ApplicationT::getInstance().addRecord(result);
     }
+
+  private:
+
+    using DataT = BenchmarkData<T_Precision,NDim>;
+
+    /**
+     * compute deviation and mismatches of the FFT output of run r (see Validation),
+     * runs or elements not compared only fail on NaN or Inf
+     */
+    static void validate(ResultT& result,
+                         const DataT& dataset,
+                         const VectorT& data_buffer,
+                         double error_bound,
+                         int r,
+                         int nruns) {
+      double deviation = 0.0; // sample standard deviation
+      size_t mismatches = 0; // nr of mismatches
+      double validated = 0.0; // fraction of compared elements
+      bool probe = true;
+      if(Validation::selects(r, nruns)) {
+        const size_t stride = Validation::stride();
+        dataset.template check_deviation<!T_FFT_Normalized::value>
+          (deviation, mismatches, data_buffer, error_bound, stride);
+        validated = static_cast<double>((dataset.total() + stride - 1) / stride)
+                    / static_cast<double>(dataset.total());
+        probe = stride > 1 && std::isfinite(deviation);
+      }
+      if(probe) {
+        size_t nonfinite = dataset.count_nonfinite(data_buffer);
+        if(nonfinite > 0) {
+          deviation = std::numeric_limits<double>::quiet_NaN();
+          mismatches += nonfinite;
+        }
+      }
+
+      result.setValue(RecordType::Deviation, deviation);
+      result.setValue(RecordType::Mismatches, static_cast<double>(mismatches));
+      result.setValue(RecordType::Validated, validated);
+    }
+
+    /// throws if the deviation of the current run is out of bound
+    static void check(ResultT& result, int r, double error_bound) {
+      double deviation = result.getValue(RecordType::Deviation);
+      if(std::isnan(deviation) || deviation>error_bound) {
+        std::stringstream msg;
+        msg << "mismatches=" << result.getValue(RecordType::Mismatches)
+            << " deviation=" << deviation
+            << " errorbound=" << error_bound;
+        result.setError(r, msg.str());
+        throw std::runtime_error(msg.str());
+      }
+    }
+
+    /// adaptive mode: true if another run is required, otherwise the number of runs is fixed
+    static bool next(ResultT& result, AdaptiveRepetition& repetition) {
+      if( repetition.next(result.getValue(RecordType::FFT),
+                          result.getValue(RecordType::FFTInv)) )
+        return true;
+      result.setNumberRuns(repetition.getNumberRuns(),
+                           repetition.getNumberWarmups());
+      return false;
+    }
+
+    /**
+     * Concurrent FFT streams, each thread owns its FFT client and buffers
+     * and executes the transforms in steady state.
+     * Clients are created and destroyed one after another (FFT planners are
+     * not required to be thread-safe), every run starts all streams at once
+     * behind a barrier. Records of a run are averaged over the streams,
+     * aggregate throughput and the slowest stream are recorded in addition.
+     */
+    class Streams {
+    public:
+      Streams(const ResultT& result,
+              const DataT& dataset,
+              const T_Extents& extents,
+              const BenchmarkConfig& config,
+              double error_bound,
+              int nruns)
+        : dataset_(dataset),
+          extents_(extents),
+          config_(config),
+          error_bound_(error_bound),
+          nruns_(nruns),
+          nstreams_(config.streams),
+          start_(nstreams_+1),
+          done_(nstreams_+1),
+          checked_(nstreams_+1),
+          results_(nstreams_, result),
+          setups_(nstreams_, result),
+          teardowns_(nstreams_, result),
+          errors_(nstreams_),
+          begins_(nstreams_),
+          ends_(nstreams_) {
+        for(size_t i = 0; i < nstreams_; ++i) {
+          threads_.emplace_back(&Streams::loop, this, i);
+        }
+      }
+
+      ~Streams() {
+        finish(nullptr);
+      }
+
+      /// executes one run on all streams and aggregates the records into result
+      void run(ResultT& result) {
+        // the peak RSS is process-wide, it is reset once before the streams start
+        MemoryUsage::resetPeak();
+        start_.wait();
+        done_.wait();
+        checked_.wait();
+        throwOnError();
+        // wall time from the first stream starting to the last one finishing
+        auto begin = *std::min_element(begins_.begin(), begins_.end());
+        auto end = *std::max_element(ends_.begin(), ends_.end());
+        double time = std::chrono::duration<double, std::milli>(end - begin).count();
+
+        const bool setup = !setupReported_;
+        setupReported_ = true;
+        for(int ival = 0; ival < ApplicationT::NR_RECORDS; ++ival) {
+          double sum = 0.0;
+          double peak = 0.0;
+          for(const auto& stream : results_) {
+            sum += stream.getValue(ival);
+            peak = std::max(peak, stream.getValue(ival));
+          }
+          if(ival == static_cast<int>(RecordType::MemoryPeak))
+            result.setValue(ival, peak);
+          else
+            result.setValue(ival, sum / static_cast<double>(nstreams_));
+        }
+        double deviation = 0.0;
+        double mismatches = 0.0;
+        double slowest_fft = 0.0;
+        double slowest_ifft = 0.0;
+        double reps_fft = 0.0;
+        double reps_ifft = 0.0;
+        double transforms = 0.0;
+        for(const auto& stream : results_) {
+          // inner repetition executes the timed transforms and one untimed round trip
+          double fft = InnerRepetition::isEnabled() ? stream.getValue(RecordType::InnerRepetitionsFFT) : 1.0;
+          double ifft = InnerRepetition::isEnabled() ? stream.getValue(RecordType::InnerRepetitionsFFTInv) : 1.0;
+          reps_fft += fft;
+          reps_ifft += ifft;
+          transforms += fft + ifft + (fft > 1.0 || ifft > 1.0 ? 2.0 : 0.0);
+          deviation = std::max(deviation, stream.getValue(RecordType::Deviation));
+          if(std::isnan(stream.getValue(RecordType::Deviation)))
+            deviation = stream.getValue(RecordType::Deviation);
+          mismatches += stream.getValue(RecordType::Mismatches);
+          slowest_fft = std::max(slowest_fft, stream.getValue(RecordType::FFT));
+          slowest_ifft = std::max(slowest_ifft, stream.getValue(RecordType::FFTInv));
+        }
+        result.setValue(RecordType::Deviation, deviation);
+        result.setValue(RecordType::Mismatches, mismatches);
+        result.setValue(RecordType::StreamsTime, time);
+        // forward and inverse transforms executed by all streams per second
+        result.setValue(RecordType::StreamsThroughput,
+                        time > 0.0
+                        ? 1.0e3 * transforms * static_cast<double>(config_.batch) / time
+                        : 0.0);
+        if(InnerRepetition::isEnabled()) { // total over the streams
+          result.setValue(RecordType::InnerRepetitionsFFT, reps_fft);
+          result.setValue(RecordType::InnerRepetitionsFFTInv, reps_ifft);
+        }
+        result.setValue(RecordType::StreamsSlowestFFT, slowest_fft);
+        result.setValue(RecordType::StreamsSlowestFFTInv, slowest_ifft);
+        if(setup) // first run reports allocation and planning of the streams
+          merge(result, setups_);
+      }
+
+      /// stops the streams, the teardown records of the clients are added to result
+      void finish(ResultT* result) {
+        if(threads_.empty())
+          return;
+        stop_ = true;
+        start_.wait();
+        for(auto& t : threads_)
+          t.join();
+        threads_.clear();
+        if(result) {
+          merge(*result, teardowns_);
+          throwOnError();
+        }
+      }
+
+    private:
+      using ClockT = std::chrono::steady_clock;
+      const DataT& dataset_;
+      const T_Extents extents_;
+      const BenchmarkConfig config_;
+      const double error_bound_;
+      const int nruns_;
+      const size_t nstreams_;
+      Barrier start_;
+      Barrier done_;
+      Barrier checked_;
+      std::mutex setup_mutex_;
+      std::atomic<bool> stop_{false};
+      bool setupReported_ = false;
+      /// records of the current run per stream
+      std::vector<ResultT> results_;
+      /// allocation and planning records per stream
+      std::vector<ResultT> setups_;
+      /// destroy records per stream
+      std::vector<ResultT> teardowns_;
+      std::vector<std::string> errors_;
+      std::vector<ClockT::time_point> begins_;
+      std::vector<ClockT::time_point> ends_;
+      std::vector<std::thread> threads_;
+
+      /**
+       * Adds the records of a phase outside the runs (setup or teardown of the streams),
+       * averaged over the streams, to result. The peak RSS is the maximum.
+       */
+      void merge(ResultT& result, const std::vector<ResultT>& phases) const {
+        for(int ival = 0; ival < ApplicationT::NR_RECORDS; ++ival) {
+          double sum = 0.0;
+          double peak = 0.0;
+          for(const auto& phase : phases) {
+            sum += phase.getValue(ival);
+            peak = std::max(peak, phase.getValue(ival));
+          }
+          if(ival == static_cast<int>(RecordType::MemoryPeak))
+            result.setValue(ival, std::max(result.getValue(ival), peak));
+          else
+            result.setValue(ival, result.getValue(ival) + sum / static_cast<double>(nstreams_));
+        }
+      }
+
+      void throwOnError() {
+        for(size_t i = 0; i < nstreams_; ++i) {
+          if(!errors_[i].empty())
+            throw std::runtime_error("stream " + std::to_string(i) + ": " + errors_[i]);
+        }
+      }
+
+      /// body of stream i, errors are stored and the stream keeps taking part in the barriers
+      void loop(size_t i) {
+        CpuPlacement::setSlot(i);
+        auto fft = T_FFT_Wrapper();
+        VectorT data_buffer;
+        ResultT& result = results_[i];
+        auto guard = [&](auto&& f) {
+          if(!errors_[i].empty())
+            return;
+          try {
+            f();
+          } catch(const std::exception& e) {
+            errors_[i] = e.what();
+          }
+        };
+        guard([&]() {
+            dataset_.copyTo(data_buffer);
+            std::lock_guard<std::mutex> lock(setup_mutex_);
+            fft.prepare(setups_[i], data_buffer, extents_, config_.batch);
+          });
+        for(int r = 0; ; ++r) {
+          guard([&]() { dataset_.copyTo(data_buffer); });
+          start_.wait();
+          if(stop_)
+            break;
+          // the record of the stream is reused by every run
+          result.clearValues();
+          begins_[i] = ClockT::now();
+          guard([&]() { fft.steady(result, data_buffer, extents_, config_.batch, false); });
+          ends_[i] = ClockT::now();
+          done_.wait();
+          guard([&]() { validate(result, dataset_, data_buffer, error_bound_, r, nruns_); });
+          checked_.wait();
+        }
+        guard([&]() {
+            std::lock_guard<std::mutex> lock(setup_mutex_);
+            fft.teardown(teardowns_[i]);
+          });
+      }
+    };
   };
 
 } // gearshifft
@@ -7,6 +7,8 @@
 #include "types.hpp"
 
 #include <array>
+#include <string>
+#include <vector>
 
 #include <boost/bind/bind.hpp>
 
@@ -27,8 +29,17 @@ namespace gearshifft {
     template<typename T_Extents>
     struct Apply {
       const T_Extents e_;
+      const std::vector<size_t> batches_;
+      const std::vector<size_t> streams_;
+      const std::vector<size_t> ndevices_;
+      const std::vector<std::string> planners_;
       test_suite* ts_;
-      explicit Apply(const T_Extents& e) : e_(e) {
+      explicit Apply(const T_Extents& e)
+        : e_(e),
+          batches_(T_Context::options().getBatches()),
+          streams_(T_Context::options().getStreams()),
+          ndevices_(T_Context::options().getNumberDevicesList()),
+          planners_(T_Context::options().getPlanners()) {
         std::stringstream ss;
         ss << e;
         ts_ = BOOST_TEST_SUITE( ss.str() );
@@ -42,11 +53,36 @@ namespace gearshifft {
                                                      T_Precision,
                                                      T_Extents>;
         BenchmarkExecutorT benchmark;
-        boost::unit_test::test_case* s = BOOST_TEST_CASE(
-            boost::bind((&BenchmarkExecutorT::operator()), benchmark, e_)
-          );
-        s->p_name.value = FFT::Title;
-        ts_->add(s);
+        for(auto batch : batches_) {
+          for(auto streams : streams_) {
+            for(auto ndevices : ndevices_) {
+              for(const auto& planner : planners_) {
+                BenchmarkConfig config;
+                config.batch = batch;
+                config.streams = streams;
+                config.ndevices = ndevices;
+                config.planner = planner;
+                boost::unit_test::test_case* s = BOOST_TEST_CASE(
+                    boost::bind((&BenchmarkExecutorT::operator()), benchmark, e_, config)
+                  );
+                s->p_name.value = FFT::Title;
+                if(batch != 1) {
+                  s->p_name.value += "_batch" + std::to_string(batch);
+                }
+                if(T_Context::options().isStreamsMode()) {
+                  s->p_name.value += "_streams" + std::to_string(streams);
+                }
+                if(T_Context::options().isNumberDevicesSweep()) {
+                  s->p_name.value += "_ndevices" + std::to_string(ndevices);
+                }
+                if(planners_.size() > 1) {
+                  s->p_name.value += "_" + planner;
+                }
+                ts_->add(s);
+              }
+            }
+          }
+        }
       }
       test_suite* result() { return ts_; }
     }; // Apply
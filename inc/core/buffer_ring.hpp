@@ -0,0 +1,114 @@
+#ifndef BUFFER_RING_HPP_
+#define BUFFER_RING_HPP_
+
+#include "cache_flush.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace gearshifft {
+
+  /**
+   * Rotating buffer set for cache-cold execution without flushing (--buffer-ring).
+   *
+   * A client keeps M buffer pairs (input and output) instead of one, each
+   * forward transform runs on the next pair, the inverse transform follows on
+   * the same pair.  The pairs are filled with the input once (prime(), not
+   * timed), afterwards upload() refills the pair executed last, which is
+   * executed again only after the M-1 other pairs, so its data is evicted from
+   * the caches if the M-1 pairs exceed the last level cache.
+   * With 'auto' M is chosen so that M-1 pairs cover twice the LLC size,
+   * otherwise M is given.  One instance per client tracks the current pair.
+   */
+  class BufferRing {
+  public:
+
+    /// off, auto or number of buffer pairs
+    static bool isValidSpec(const std::string& spec) {
+      if(spec=="off" || spec=="auto")
+        return true;
+      if(spec.empty() || spec.find_first_not_of("0123456789")!=std::string::npos)
+        return false;
+      return std::stoul(spec) > 0;
+    }
+
+    static void configure(const std::string& spec) {
+      spec_() = spec;
+    }
+
+    static bool isEnabled() {
+      return spec_()!="off";
+    }
+
+    /// number of buffer pairs for pairs of pairBytes (1 if disabled)
+    static size_t count(size_t pairBytes) {
+      if(!isEnabled())
+        return 1;
+      if(spec_()!="auto")
+        return std::stoul(spec_());
+      size_t cover = 2 * CacheFlush::llcSize();
+      return std::max<size_t>(2, (cover + pairBytes - 1) / std::max<size_t>(pairBytes, 1) + 1);
+    }
+
+    /// csv meta information, empty if disabled
+    static std::string properties() {
+      if(!isEnabled())
+        return "";
+      std::ostringstream msg;
+      msg << ",\"BufferRing\",\"" << spec_() << "\"";
+      if(spec_()=="auto")
+        msg << ",\"BufferRingCover [bytes]\"," << 2 * CacheFlush::llcSize();
+      return msg.str();
+    }
+
+    explicit BufferRing(size_t pairs = 1) : count_(std::max<size_t>(pairs, 1)) {}
+
+    size_t size() const {
+      return count_;
+    }
+
+    /// pair of the next execution
+    size_t current() const {
+      return current_;
+    }
+
+    /// pair executed last, refilled by upload and read by download
+    size_t previous() const {
+      return (current_ + count_ - 1) % count_;
+    }
+
+    /// called after the inverse transform
+    void advance() {
+      current_ = (current_ + 1) % count_;
+    }
+
+    bool isPrimed() const {
+      return primed_;
+    }
+
+    /// all pairs hold the input, called by prime() of the client
+    void setPrimed(bool primed) {
+      primed_ = primed;
+    }
+
+    /// pairs in fill order, the current pair first (least recently touched)
+    size_t fillOrder(size_t i) const {
+      return (current_ + i) % count_;
+    }
+
+  private:
+    size_t count_ = 1;
+    size_t current_ = 0;
+    bool primed_ = false;
+
+    static std::string& spec_() {
+      static std::string spec = "off";
+      return spec;
+    }
+  };
+
+} // gearshifft
+
+#endif /* BUFFER_RING_HPP_ */
@@ -0,0 +1,233 @@
+#ifndef CACHE_FLUSH_HPP_
+#define CACHE_FLUSH_HPP_
+
+#include "timer_cpu.hpp"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <boost/align/aligned_alloc.hpp>
+#pragma GCC diagnostic pop
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define GEARSHIFFT_HAS_CLFLUSH 1
+#endif
+
+/// fallback if the last level cache size cannot be detected
+#ifndef GEARSHIFFT_FLUSH_LLC_SIZE_MEBIBYTES
+#define GEARSHIFFT_FLUSH_LLC_SIZE_MEBIBYTES 32
+#endif
+
+/// fallback if the cache line size cannot be detected
+#ifndef GEARSHIFFT_FLUSH_CL_SIZE_BYTES
+#define GEARSHIFFT_FLUSH_CL_SIZE_BYTES 64
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Evicts the caches before plan and execution steps (--flush-cache).
+   *
+   * The last level cache and cache line sizes are read from sysfs (cpu0,
+   * highest cache level), from sysconf (cpuid) otherwise, else the compile-time
+   * fallbacks are used.  A flush writes a buffer of twice the LLC size
+   * (memset, vectorized by the C library), which evicts the FFT data, and then
+   * flushes the last LLC size of it with clflushopt (clflush if not supported,
+   * x86 only), so the caches do not hold dirty lines of the flush buffer either.
+   * Flushing lines which are not cached is expensive, hence only the part of
+   * the buffer which can still be cached is flushed.
+   * The buffer is allocated and touched on first use per thread (not timed).
+   */
+  class CacheFlush {
+  public:
+
+    static void enable(bool enabled) {
+      enabled_() = enabled;
+    }
+
+    static bool isEnabled() {
+      return enabled_();
+    }
+
+    /// flush buffer of the calling thread
+    static CacheFlush& get() {
+      thread_local CacheFlush flush;
+      return flush;
+    }
+
+    /// evicts the caches if enabled, returns the time [ms] spent
+    double operator()() {
+      if(!isEnabled())
+        return 0.0;
+      if(!buffer_) {
+        buffer_.reset(static_cast<char*>(boost::alignment::aligned_alloc(lineSize(), size_)));
+        if(!buffer_)
+          throw std::bad_alloc();
+        std::memset(buffer_.get(), 0, size_);
+      }
+      TimerCPU timer;
+      timer.startTimer();
+      char* p = buffer_.get();
+      std::memset(p, static_cast<int>(++pattern_), size_);
+      // the buffer is never read, keep the compiler from removing the stores
+      asm volatile("" : : "r"(p) : "memory");
+#ifdef GEARSHIFFT_HAS_CLFLUSH
+      const size_t tail = std::min(size_, llcSize());
+      if(hasClflushopt())
+        clflushopt(p + size_ - tail, tail, lineSize());
+      else
+        clflush(p + size_ - tail, tail, lineSize());
+#endif
+      return timer.stopTimer();
+    }
+
+    static size_t llcSize() {
+      return caches().llc;
+    }
+
+    static size_t lineSize() {
+      return caches().line;
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      msg << ",\"FlushCache\"," << isEnabled();
+      if(isEnabled()) {
+        msg << ",\"LLC [bytes]\"," << llcSize()
+            << ",\"CacheLine [bytes]\"," << lineSize()
+            << ",\"CacheSizeSource\",\"" << caches().source << "\"";
+      }
+      return msg.str();
+    }
+
+  private:
+    struct Caches {
+      size_t llc = 0;
+      size_t line = 0;
+      const char* source = "fallback";
+    };
+
+    struct AlignedFree {
+      void operator()(char* p) const { boost::alignment::aligned_free(p); }
+    };
+
+    std::unique_ptr<char, AlignedFree> buffer_;
+    size_t size_ = 2 * llcSize();
+    unsigned char pattern_ = 0;
+
+    CacheFlush() = default;
+
+#ifdef GEARSHIFFT_HAS_CLFLUSH
+    static bool hasClflushopt() {
+      static const bool supported = []() {
+        unsigned a = 0, b = 0, c = 0, d = 0;
+        if(!__get_cpuid_count(7, 0, &a, &b, &c, &d))
+          return false;
+        return (b & (1u << 23)) != 0;
+      }();
+      return supported;
+    }
+
+    __attribute__((target("clflushopt")))
+    static void clflushopt(char* p, size_t bytes, size_t line) {
+      for(size_t i = 0; i < bytes; i += line)
+        _mm_clflushopt(p + i);
+      _mm_sfence();
+    }
+
+    static void clflush(char* p, size_t bytes, size_t line) {
+      for(size_t i = 0; i < bytes; i += line)
+        _mm_clflush(p + i);
+      _mm_mfence();
+    }
+#endif
+
+    static bool& enabled_() {
+      static bool enabled = false;
+      return enabled;
+    }
+
+    static const Caches& caches() {
+      static const Caches c = detect();
+      return c;
+    }
+
+    /// parses sysfs cache sizes like "32768K"
+    static size_t parseSize(const std::string& s) {
+      if(s.empty())
+        return 0;
+      size_t pos = 0;
+      size_t value = std::stoul(s, &pos);
+      if(pos < s.size() && (s[pos]=='K' || s[pos]=='k'))
+        value <<= 10;
+      else if(pos < s.size() && s[pos]=='M')
+        value <<= 20;
+      return value;
+    }
+
+    static std::string readLine(const std::string& file) {
+      std::ifstream ifs(file);
+      std::string line;
+      std::getline(ifs, line);
+      return line;
+    }
+
+    static Caches detect() {
+      Caches c;
+      // sysfs: highest level unified or data cache of cpu0
+      int level = 0;
+      for(int i = 0; ; ++i) {
+        std::string dir = "/sys/devices/system/cpu/cpu0/cache/index"+std::to_string(i)+"/";
+        std::string lvl = readLine(dir+"level");
+        if(lvl.empty())
+          break;
+        if(readLine(dir+"type")=="Instruction")
+          continue;
+        int l = std::stoi(lvl);
+        size_t size = parseSize(readLine(dir+"size"));
+        if(l >= level && size > 0) {
+          level = l;
+          c.llc = size;
+          c.line = parseSize(readLine(dir+"coherency_line_size"));
+          c.source = "sysfs";
+        }
+      }
+#if defined(__linux__) && defined(_SC_LEVEL3_CACHE_SIZE)
+      if(c.llc == 0) {
+        long l3 = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        long l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+        if(l3 > 0 || l2 > 0) {
+          c.llc = static_cast<size_t>(l3 > 0 ? l3 : l2);
+          c.line = line > 0 ? static_cast<size_t>(line) : 0;
+          c.source = "sysconf";
+        }
+      }
+#endif
+      if(c.llc == 0)
+        c.llc = size_t(GEARSHIFFT_FLUSH_LLC_SIZE_MEBIBYTES) << 20;
+      if(c.line == 0)
+        c.line = GEARSHIFFT_FLUSH_CL_SIZE_BYTES;
+      return c;
+    }
+  };
+
+} // gearshifft
+
+#endif /* CACHE_FLUSH_HPP_ */
@@ -0,0 +1,317 @@
+#ifndef CPU_PLACEMENT_HPP_
+#define CPU_PLACEMENT_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace gearshifft {
+
+  /**
+   * NUMA memory policy and CPU pinning of the benchmark threads (--numa-policy, --pin).
+   *
+   * The memory policy is set for the benchmark thread by configure(), threads
+   * created later (streams, library threads) inherit it.  The CPU backends
+   * additionally bind their FFT buffers with bind(), so the policy also holds
+   * for pages first touched by library threads.
+   * Pinning orders the allowed CPUs: compact fills one NUMA node after the
+   * other, scatter alternates between the nodes, or an explicit CPU list is used.
+   * A benchmark with p threads runs on the first p CPUs of the order (stream k
+   * on the k-th group of p CPUs), see apply().
+   * Uses the Linux system calls directly (no libnuma), failures are reported
+   * in the csv header and do not stop the benchmark.
+   */
+  class CpuPlacement {
+  public:
+
+    /// placement of the process, configured once by Benchmark::run()
+    static CpuPlacement& get() {
+      static CpuPlacement placement;
+      return placement;
+    }
+
+    /// parses a Linux cpulist like "0-3,8,10-11"
+    static std::vector<int> parseCpuList(const std::string& list) {
+      std::vector<int> cpus;
+      std::stringstream ss(list);
+      std::string token;
+      while(std::getline(ss, token, ',')) {
+        token.erase(std::remove_if(token.begin(), token.end(), ::isspace), token.end());
+        if(token.empty())
+          continue;
+        size_t pos = token.find('-');
+        int first = std::stoi(token.substr(0, pos));
+        int last = pos==std::string::npos ? first : std::stoi(token.substr(pos+1));
+        if(first<0 || last<first)
+          throw std::invalid_argument("invalid cpu list '"+list+"'");
+        for(int cpu=first; cpu<=last; ++cpu)
+          cpus.push_back(cpu);
+      }
+      return cpus;
+    }
+
+    /// default, local, interleave or node:N
+    static bool isValidPolicy(const std::string& policy) {
+      if(policy=="default" || policy=="local" || policy=="interleave")
+        return true;
+      if(policy.compare(0, 5, "node:")!=0 || policy.size()==5)
+        return false;
+      return policy.find_first_not_of("0123456789", 5)==std::string::npos;
+    }
+
+    /// none, compact, scatter or a cpu list
+    static bool isValidPin(const std::string& pinning) {
+      if(pinning=="none" || pinning=="compact" || pinning=="scatter")
+        return true;
+      try {
+        return !parseCpuList(pinning).empty();
+      } catch(const std::exception&) {
+        return false;
+      }
+    }
+
+    /// stream index of the calling thread, selects its group of CPUs in apply()
+    static void setSlot(size_t slot) {
+      slot_() = slot;
+    }
+
+    /**
+     * Reads the NUMA topology, sets the memory policy of the calling thread
+     * and pins it to all CPUs of the pinning order.
+     */
+    void configure(const std::string& policy, const std::string& pinning) {
+      policy_ = policy;
+      pin_ = pinning;
+      readTopology();
+      order_.clear();
+      if(pin_=="compact") {
+        for(const auto& node : nodes_)
+          order_.insert(order_.end(), node.begin(), node.end());
+      } else if(pin_=="scatter") {
+        size_t total = 0;
+        for(const auto& node : nodes_)
+          total += node.size();
+        for(size_t i=0; order_.size()<total; ++i) {
+          for(const auto& node : nodes_)
+            if(i<node.size())
+              order_.push_back(node[i]);
+        }
+      } else if(pin_!="none") {
+        order_ = parseCpuList(pin_);
+      }
+      if(!order_.empty())
+        pin(order_);
+      setPolicy();
+    }
+
+    /**
+     * Pins the calling thread and the OpenMP threads to the CPUs of a benchmark
+     * with nthreads threads (0=all CPUs of the order).
+     * Threads of other threading layers inherit the CPU set of the calling thread.
+     */
+    void apply(size_t nthreads) {
+      if(order_.empty())
+        return;
+      size_t p = nthreads==0 ? order_.size() : nthreads;
+      std::vector<int> cpus(p);
+      for(size_t i=0; i<p; ++i)
+        cpus[i] = order_[(slot_()*p + i) % order_.size()];
+      pin(cpus);
+#ifdef _OPENMP
+#pragma omp parallel num_threads(static_cast<int>(p))
+      {
+        size_t t = static_cast<size_t>(omp_get_thread_num());
+        pin(std::vector<int>(1, cpus[t % p]));
+      }
+      // master thread keeps the whole set for threads spawned outside of OpenMP
+      pin(cpus);
+#endif
+    }
+
+    /// applies the memory policy to the pages of a buffer (pages already present are moved)
+    void bind(void* ptr, size_t bytes) const {
+#ifdef __linux__
+      if(mode_<0 || ptr==nullptr || bytes==0 || !policyError_.empty())
+        return;
+      const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+      uintptr_t begin = reinterpret_cast<uintptr_t>(ptr) & ~(page-1);
+      uintptr_t end = reinterpret_cast<uintptr_t>(ptr) + bytes;
+      syscall(SYS_mbind, begin, end-begin, mode_,
+              mask_.empty() ? nullptr : mask_.data(),
+              maxnode(),
+              MPOL_MF_MOVE);
+#else
+      (void)ptr;
+      (void)bytes;
+#endif
+    }
+
+    /// csv meta information, empty if neither policy nor pinning is set
+    std::string properties() const {
+      if(policy_=="default" && pin_=="none")
+        return "";
+      std::ostringstream msg;
+      msg << ",\"NumaNodes\"," << nodes_.size()
+          << ",\"NumaPolicy\",\"" << policy_;
+      if(!policyError_.empty())
+        msg << " (failed: " << policyError_ << ")";
+      msg << "\",\"Pinning\",\"" << pin_;
+      if(!pinError_.empty())
+        msg << " (failed: " << pinError_ << ")";
+      msg << "\",\"PinnedCPUs\",\"";
+      for(size_t i=0; i<order_.size(); ++i)
+        msg << (i ? " " : "") << order_[i];
+      msg << "\"";
+      return msg.str();
+    }
+
+  private:
+    std::string policy_ = "default";
+    std::string pin_ = "none";
+    /// allowed CPUs per NUMA node
+    std::vector<std::vector<int>> nodes_;
+    std::vector<int> allowed_;
+    std::vector<int> order_;
+    std::vector<int> nodeIds_;
+    /// MPOL_* mode, -1 for default policy
+    int mode_ = -1;
+    std::vector<unsigned long> mask_;
+    std::string policyError_;
+    std::string pinError_;
+    std::mutex errorMutex_;
+
+    CpuPlacement() = default;
+
+    /// maxnode of mbind/set_mempolicy, the kernel reads maxnode-1 bits (as libnuma, add one)
+    unsigned long maxnode() const {
+      return mask_.empty() ? 0UL : 64UL*mask_.size()+1;
+    }
+
+    static size_t& slot_() {
+      thread_local size_t slot = 0;
+      return slot;
+    }
+
+    static std::string readLine(const std::string& file) {
+      std::ifstream ifs(file);
+      std::string line;
+      std::getline(ifs, line);
+      return line;
+    }
+
+    void readTopology() {
+      allowed_.clear();
+      nodes_.clear();
+      nodeIds_.clear();
+#ifdef __linux__
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      if(sched_getaffinity(0, sizeof(set), &set)==0) {
+        for(int cpu=0; cpu<CPU_SETSIZE; ++cpu)
+          if(CPU_ISSET(cpu, &set))
+            allowed_.push_back(cpu);
+      }
+      std::string online = readLine("/sys/devices/system/node/online");
+      if(!online.empty()) {
+        for(int node : parseCpuList(online)) {
+          std::vector<int> cpus;
+          std::string path = "/sys/devices/system/node/node"+std::to_string(node)+"/cpulist";
+          for(int cpu : parseCpuList(readLine(path)))
+            if(std::find(allowed_.begin(), allowed_.end(), cpu)!=allowed_.end())
+              cpus.push_back(cpu);
+          nodes_.push_back(cpus);
+          nodeIds_.push_back(node);
+        }
+      }
+#endif
+      if(nodes_.empty()) {
+        nodes_.push_back(allowed_);
+        nodeIds_.assign(1, 0);
+      }
+    }
+
+    /// sets the memory policy of the calling thread
+    void setPolicy() {
+      mode_ = -1;
+      mask_.clear();
+      policyError_.clear();
+      if(policy_=="default")
+        return;
+#ifdef __linux__
+      std::vector<int> nodes;
+      if(policy_=="local") {
+        mode_ = MPOL_LOCAL;
+      } else if(policy_=="interleave") {
+        mode_ = MPOL_INTERLEAVE;
+        nodes = nodeIds_;
+      } else {
+        mode_ = MPOL_BIND;
+        nodes.push_back(std::stoi(policy_.substr(5)));
+      }
+      for(int node : nodes) {
+        size_t word = static_cast<size_t>(node) / 64;
+        if(mask_.size()<=word)
+          mask_.resize(word+1, 0UL);
+        mask_[word] |= 1UL << (static_cast<size_t>(node) % 64);
+      }
+      long ret = syscall(SYS_set_mempolicy, mode_,
+                         mask_.empty() ? nullptr : mask_.data(),
+                         maxnode());
+      if(ret!=0) {
+        policyError_ = std::strerror(errno);
+        std::cerr << "gearshifft: numa policy " << policy_
+                  << " not applied (set_mempolicy: " << policyError_ << ").\n";
+      }
+#else
+      policyError_ = "not supported";
+#endif
+    }
+
+    /// pins the calling thread to cpus, returns 0 or errno
+    int pin(const std::vector<int>& cpus) {
+#ifdef __linux__
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for(int cpu : cpus)
+        if(cpu<CPU_SETSIZE)
+          CPU_SET(cpu, &set);
+      if(sched_setaffinity(0, sizeof(set), &set)==0)
+        return 0;
+      int error = errno;
+      std::lock_guard<std::mutex> lock(errorMutex_);
+      if(pinError_.empty()) {
+        pinError_ = std::strerror(error);
+        std::cerr << "gearshifft: pinning " << pin_
+                  << " not applied (sched_setaffinity: " << pinError_ << ").\n";
+      }
+      return error;
+#else
+      (void)cpus;
+      pinError_ = "not supported";
+      return -1;
+#endif
+    }
+  };
+
+} // gearshifft
+
+#endif /* CPU_PLACEMENT_HPP_ */
@@ -0,0 +1,178 @@
+#ifndef DATA_PATTERN_HPP_
+#define DATA_PATTERN_HPP_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <xmmintrin.h>
+#include <pmmintrin.h>
+#define GEARSHIFFT_HAS_MXCSR 1
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Input signal of the benchmarks (--data, --seed), see BenchmarkData.
+   *
+   * - sawtooth: 0.125*(i&7) (default)
+   * - uniform: uniform in [0,1)
+   * - gaussian: standard normal distribution
+   * - impulse: 1 at the first element of each signal, 0 otherwise
+   * - chirp: sin(pi*k^2/n), frequency sweeps from 0 to Nyquist over the n elements of a signal
+   * - denormal-heavy: sawtooth scaled by the smallest normal number of the precision,
+   *   so 7 of 8 elements are denormal
+   *
+   * Random values are computed from a counter-based hash of seed and element index,
+   * so the data neither depends on the number of threads generating it nor on the order of benchmarks.
+   */
+  class DataPattern {
+  public:
+    enum class Kind { Sawtooth, Uniform, Gaussian, Impulse, Chirp, DenormalHeavy };
+
+    static bool isValid(const std::string& name) {
+      Kind kind;
+      return parse(name, kind);
+    }
+
+    static void configure(const std::string& name, uint64_t seed) {
+      name_() = name;
+      parse(name, kind_());
+      seed_() = seed;
+    }
+
+    static Kind kind() {
+      return kind_();
+    }
+
+    /// value of element i, size is the number of elements of a signal
+    template<typename RealType>
+    static double value(size_t i, size_t size) {
+      const size_t k = i % size;
+      switch(kind_()) {
+      case Kind::Uniform:
+        return uniform(i);
+      case Kind::Gaussian: {
+        // Box-Muller, 1-u avoids log(0)
+        const double u1 = 1.0 - uniform(2*i);
+        const double u2 = uniform(2*i+1);
+        return std::sqrt(-2.0*std::log(u1)) * std::cos(2.0*M_PI*u2);
+      }
+      case Kind::Impulse:
+        return k == 0 ? 1.0 : 0.0;
+      case Kind::Chirp:
+        return std::sin(M_PI * static_cast<double>(k) * static_cast<double>(k) / static_cast<double>(size));
+      case Kind::DenormalHeavy:
+        return static_cast<double>(std::numeric_limits<RealType>::min()) * 0.125*(i&7);
+      case Kind::Sawtooth:
+        break;
+      }
+      return 0.125*(i&7);
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      msg << ",\"Data\",\"" << name_() << "\""
+          << ",\"Seed\"," << seed_();
+      return msg.str();
+    }
+
+  private:
+    static std::string& name_() {
+      static std::string name = "sawtooth";
+      return name;
+    }
+
+    static Kind& kind_() {
+      static Kind kind = Kind::Sawtooth;
+      return kind;
+    }
+
+    static uint64_t& seed_() {
+      static uint64_t seed = 0;
+      return seed;
+    }
+
+    /// splitmix64 of seed and counter mapped to [0,1)
+    static double uniform(uint64_t counter) {
+      uint64_t z = seed_() + (counter + 1) * 0x9e3779b97f4a7c15ULL;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      z ^= z >> 31;
+      return static_cast<double>(z >> 11) * 0x1.0p-53;
+    }
+
+    static bool parse(const std::string& name, Kind& kind) {
+      if(name == "sawtooth")
+        kind = Kind::Sawtooth;
+      else if(name == "uniform")
+        kind = Kind::Uniform;
+      else if(name == "gaussian")
+        kind = Kind::Gaussian;
+      else if(name == "impulse")
+        kind = Kind::Impulse;
+      else if(name == "chirp")
+        kind = Kind::Chirp;
+      else if(name == "denormal-heavy")
+        kind = Kind::DenormalHeavy;
+      else
+        return false;
+      return true;
+    }
+  };
+
+  /**
+   * Flush-to-zero (--ftz) and denormals-are-zero (--daz) modes of the SSE/AVX unit (MXCSR).
+   * Set for the benchmark thread before the context is created,
+   * threads created afterwards (FFT library, OpenMP, streams) inherit the mode.
+   */
+  class Denormals {
+  public:
+
+    static bool isSupported() {
+#ifdef GEARSHIFFT_HAS_MXCSR
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    static void configure(bool ftz, bool daz) {
+#ifdef GEARSHIFFT_HAS_MXCSR
+      _MM_SET_FLUSH_ZERO_MODE(ftz ? _MM_FLUSH_ZERO_ON : _MM_FLUSH_ZERO_OFF);
+      _MM_SET_DENORMALS_ZERO_MODE(daz ? _MM_DENORMALS_ZERO_ON : _MM_DENORMALS_ZERO_OFF);
+#endif
+      ftz_() = ftz;
+      daz_() = daz;
+    }
+
+    /// csv meta information, modes actually set
+    static std::string properties() {
+      std::ostringstream msg;
+      if(isSupported())
+        msg << ",\"FTZ\"," << ftz_() << ",\"DAZ\"," << daz_();
+      else
+        msg << ",\"FTZ\",\"n/a\",\"DAZ\",\"n/a\"";
+      return msg.str();
+    }
+
+  private:
+    static bool& ftz_() {
+      static bool ftz = false;
+      return ftz;
+    }
+
+    static bool& daz_() {
+      static bool daz = false;
+      return daz;
+    }
+  };
+
+} // gearshifft
+
+#endif /* DATA_PATTERN_HPP_ */
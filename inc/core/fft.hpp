@@ -1,15 +1,27 @@
 #ifndef FFT_HPP_
 #define FFT_HPP_
 
+#include "alloc_tracker.hpp"
+#include "buffer_ring.hpp"
+#include "cache_flush.hpp"
+#include "huge_pages.hpp"
+#include "inner_repetition.hpp"
+#include "latency_histogram.hpp"
+#include "memory_usage.hpp"
+#include "os_noise.hpp"
+#include "perf_counters.hpp"
 #include "timer_cpu.hpp"
 #include "traits.hpp"
 #include "types.hpp"
 
 #include <array>
 #include <assert.h>
+#include <functional>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <ostream>
+#include <stdexcept>
 #include <type_traits>
 
 #ifdef GEARSHIFFT_SCOREP_INSTRUMENTATION
@@ -18,20 +30,6 @@
 #define SCOREP_USER_REGION(...)
 #endif
 
-#ifdef GEARSHIFFT_FLUSH_CACHE
-#define FLUSH(...) flush()
-#else
-#define FLUSH(...)
-#endif
-
-#ifndef GEARSHIFFT_FLUSH_LLC_SIZE_MEBIBYTES
-#define GEARSHIFFT_FLUSH_LLC_SIZE_MEBIBYTES 32
-#endif
-
-#ifndef GEARSHIFFT_FLUSH_CL_SIZE_BYTES
-#define GEARSHIFFT_FLUSH_CL_SIZE_BYTES 64
-#endif
-
 namespace gearshifft {
 
   struct FFT_Inplace_Real {
@@ -60,8 +58,41 @@ namespace gearshifft {
   using FFT_Plan_Reusable = std::true_type;
   using FFT_Plan_Not_Reusable = std::false_type;
 
+  /**
+   * Creates the FFT client.
+   * Clients supporting batched transforms provide a constructor (extents, batch),
+   * all others are restricted to a batch of 1.
+   */
+  template<typename T_ClientImpl, size_t NDim>
+  typename std::enable_if<std::is_constructible<T_ClientImpl,
+                                                const std::array<size_t,NDim>&,
+                                                size_t>::value,
+                          std::unique_ptr<T_ClientImpl> >::type
+  make_client(const std::array<size_t,NDim>& extents, size_t batch) {
+    return std::unique_ptr<T_ClientImpl>(new T_ClientImpl(extents, batch));
+  }
+
+  template<typename T_ClientImpl, size_t NDim>
+  typename std::enable_if<!std::is_constructible<T_ClientImpl,
+                                                 const std::array<size_t,NDim>&,
+                                                 size_t>::value,
+                          std::unique_ptr<T_ClientImpl> >::type
+  make_client(const std::array<size_t,NDim>& extents, size_t batch) {
+    if(batch != 1)
+      throw std::runtime_error("Batched transforms are not supported by this FFT library.");
+    return std::unique_ptr<T_ClientImpl>(new T_ClientImpl(extents));
+  }
+
 /**
  * Functor being called by BenchmarkExecutor
+ *
+ * By default each run creates the client, allocates, plans, transforms and
+ * destroys everything (operator()).
+ * In steady-state mode the client with its memory and plans is created by
+ * the first run (or by prepare()) and kept until teardown(), so subsequent
+ * runs only time upload, transforms and download (steady()).
+ * With --inner-time the transforms are repeated back-to-back per timed step,
+ * the count is calibrated by the first run of the benchmark (see InnerRepetition).
  */
   template<typename T_FFT, // FFT_*_* [inplace.., real..]
            typename T_ReusePlan, // can plan be reused ?
@@ -70,136 +101,492 @@ namespace gearshifft {
            typename... T_ClientArgs
            >
   struct FFT : public T_FFT {
+
+    template<typename T_Vector, size_t NDim>
+    using ClientT = T_Client<T_FFT,
+                             typename Precision<typename T_Vector::value_type,
+                                                T_FFT::IsComplex >::type,
+                             NDim,
+                             T_ClientArgs...>;
+
     /**
      * Called by BenchmarkExecutor
-     * \tparam T_Result ResultBenchmark<NR_RUNS, NR_RECORDS>, also see class Application.
+     * \tparam T_Result ResultBenchmark<NR_RECORDS>, also see class Application.
      * \tparam T_Vector
      * \tparam NDim Number of FFT dimensions
+     * \param batch Number of transforms executed by one plan
      */
     template<typename T_Result, typename T_Vector, size_t NDim>
     void operator()(T_Result& result,
                     T_Vector& vec,
-                    const std::array<size_t,NDim>& extents
-      ) const {
+                    const std::array<size_t,NDim>& extents,
+                    size_t batch = 1
+      ) {
       SCOREP_USER_REGION("fft_benchmark", SCOREP_USER_REGION_TYPE_FUNCTION)
 
-      using PrecisionT = typename Precision<typename T_Vector::value_type,
-                                            T_FFT::IsComplex >::type;
       assert(vec.size());
 
       // prepare plan object
       // templates in: FFT type: in[,out][complex], PlanImpl, Precision, NDim
-      auto fft = T_Client<T_FFT, PrecisionT, NDim, T_ClientArgs...> (extents);
-      result.setValue(RecordType::DevBufferSize, fft.get_allocation_size());
-      result.setValue(RecordType::DevPlanSize, fft.get_plan_size());
-      result.setValue(RecordType::DevTransferSize, fft.get_transfer_size());
+      check_inner_repetition();
+      auto fft = make_client<ClientT<T_Vector, NDim> >(extents, batch);
 
       TimerCPU tcpu_total;
       TimerCPU tcpu;
-      T_DeviceTimer tdev;
+      MemoryUsage::resetPeak();
       /// --- Total CPU ---
       tcpu_total.startTimer();
 
+      run(result, *fft, vec, true, inner_);
+      double total = tcpu_total.stopTimer();
+      result.setValue(RecordType::SetupPaid, 1.0);
+      page_sizes(result, *fft, vec);
+
+      /// --- Cleanup ---
+      size_t rss = MemoryUsage::rss();
+      AllocTracker::start();
+      tcpu.startTimer();
+      fft->destroy();
+      double destroy = tcpu.stopTimer();
+      allocations(result, RecordType::AllocDestroyBytes, nullptr);
+      result.setValue(RecordType::PlanDestroy, destroy);
+      memory(result, RecordType::MemoryPlanDestroy, rss);
+      memory_peak(result);
+
+      result.setValue(RecordType::Total, total + destroy);
+      // exported once by teardown() after the last run
+      result.setValue(RecordType::WisdomExport, 0.0);
+      export_wisdom_ = []() { return client_export_wisdom<ClientT<T_Vector, NDim> >(0); };
+    }
+
+    /**
+     * Steady-state run called by BenchmarkExecutor.
+     * The first call creates the client, allocates memory and creates the plans,
+     * further calls reuse them. Setup_Paid tells which run paid the setup.
+     * Call teardown() after the last run.
+     * \param reset_peak false if the caller resets the peak RSS (concurrent streams)
+     */
+    template<typename T_Result, typename T_Vector, size_t NDim>
+    void steady(T_Result& result,
+                T_Vector& vec,
+                const std::array<size_t,NDim>& extents,
+                size_t batch = 1,
+                bool reset_peak = true) {
+      SCOREP_USER_REGION("fft_benchmark_steady", SCOREP_USER_REGION_TYPE_FUNCTION)
+
+      using Client = ClientT<T_Vector, NDim>;
+      assert(vec.size());
+
+      const bool setup = !client_;
+      if(setup) {
+        check_steady_state();
+        check_inner_repetition();
+        std::shared_ptr<Client> fft = make_client<Client>(extents, batch);
+        client_ = fft;
+        destroy_ = [fft]() { fft->destroy(); };
+        export_wisdom_ = []() { return client_export_wisdom<Client>(0); };
+      }
+      auto& fft = *std::static_pointer_cast<Client>(client_);
+
+      if(reset_peak)
+        MemoryUsage::resetPeak();
+      TimerCPU tcpu_total;
+      tcpu_total.startTimer();
+
+      run(result, fft, vec, setup, inner_);
+
+      result.setValue(RecordType::PlanDestroy, 0.0);
+      result.setValue(RecordType::SetupPaid, setup ? 1.0 : 0.0);
+      result.setValue(RecordType::Total, tcpu_total.stopTimer());
+      page_sizes(result, fft, vec);
+      result.setValue(RecordType::MemoryPlanDestroy, 0.0);
+      memory_peak(result);
+    }
+
+    /**
+     * Creates the steady-state client, allocates memory and creates both plans
+     * without executing a transform. Following steady() calls reuse them.
+     * Only the setup is recorded (sizes are recorded by the runs).
+     * \param vec Only used for the type of the data
+     */
+    template<typename T_Result, typename T_Vector, size_t NDim>
+    void prepare(T_Result& result,
+                 const T_Vector& vec,
+                 const std::array<size_t,NDim>& extents,
+                 size_t batch = 1) {
+      using Client = ClientT<T_Vector, NDim>;
+      (void)vec;
+      check_steady_state();
+      std::shared_ptr<Client> fft = make_client<Client>(extents, batch);
+      client_ = fft;
+      destroy_ = [fft]() { fft->destroy(); };
+      export_wisdom_ = []() { return client_export_wisdom<Client>(0); };
+
+      MemoryUsage::resetPeak();
+      TimerCPU tcpu_total;
+      tcpu_total.startTimer();
+      result.setValue(RecordType::FlushTime, 0.0);
+      allocate_and_plan(result, *fft, true);
+      result.setValue(RecordType::SetupPaid, 1.0);
+      result.setValue(RecordType::Total, tcpu_total.stopTimer());
+      memory_peak(result);
+    }
+
+    /**
+     * Called after the last run of a benchmark: destroys the steady-state client,
+     * destroy time is added to the current run, and exports the wisdom once.
+     */
+    template<typename T_Result>
+    void teardown(T_Result& result) {
+      if(export_wisdom_) {
+        result.setValue(RecordType::WisdomExport, export_wisdom_());
+        export_wisdom_ = nullptr;
+      }
+      if(!client_)
+        return;
+      size_t rss = MemoryUsage::rss();
+      AllocTracker::start();
+      TimerCPU tcpu;
+      tcpu.startTimer();
+      destroy_();
+      double time = tcpu.stopTimer();
+      allocations(result, RecordType::AllocDestroyBytes, nullptr);
+      result.setValue(RecordType::PlanDestroy, time);
+      memory(result, RecordType::MemoryPlanDestroy, rss);
+      result.setValue(RecordType::Total, result.getValue(RecordType::Total) + time);
+      destroy_ = nullptr;
+      client_.reset();
+    }
+
+  private:
+    /// steady-state client (type depends on precision and dimension of the benchmark)
+    std::shared_ptr<void> client_;
+    std::function<void()> destroy_;
+    /// exports the wisdom of the benchmark's client type, see client_export_wisdom()
+    std::function<double()> export_wisdom_;
+    /// repetitions per timed transform, calibrated by the first run
+    InnerRepetition inner_;
+
+    /// reusable plans are replaced by init_inverse(), so they cannot be kept across runs
+    static void check_steady_state() {
+      if(T_ReusePlan::value)
+        throw std::runtime_error("Steady-state execution requires separate forward and inverse plans, which are not provided by this FFT library.");
+    }
+
+    /// the round trip is restored after the repetitions, which requires separate plans as well
+    static void check_inner_repetition() {
+      if(T_ReusePlan::value && InnerRepetition::isEnabled())
+        throw std::runtime_error("Inner repetition requires separate forward and inverse plans, which are not provided by this FFT library.");
+    }
+
+    /**
+     * Allocates memory and creates the forward plan, the inverse plan is
+     * created if plan_inverse is true.
+     */
+    template<typename T_Result, typename T_ClientImpl>
+    static void allocate_and_plan(T_Result& result, T_ClientImpl& fft, bool plan_inverse) {
+      TimerCPU tcpu;
       // allocate memory
+      size_t rss = MemoryUsage::rss();
       tcpu.startTimer();
       fft.allocate();
       result.setValue(RecordType::Allocation, tcpu.stopTimer());
+      memory(result, RecordType::MemoryAllocation, rss);
 
       {
-        FLUSH();
+        flush(result);
         SCOREP_USER_REGION("plan_forward", SCOREP_USER_REGION_TYPE_DYNAMIC)
         // init forward plan
+        rss = MemoryUsage::rss();
+        AllocTracker::start();
         tcpu.startTimer();
         fft.init_forward();
         result.setValue(RecordType::PlanInitFwd, tcpu.stopTimer());
+        allocations(result, RecordType::AllocPlanBytes, RecordType::AllocPlanCount);
+        memory(result, RecordType::MemoryPlanInitFwd, rss);
       }
 
-      if(!T_ReusePlan::value) {
-        FLUSH();
+      if(plan_inverse) {
+        flush(result);
         SCOREP_USER_REGION("plan_backward_no_reuse", SCOREP_USER_REGION_TYPE_DYNAMIC)
         // init inverse plan
+        rss = MemoryUsage::rss();
+        AllocTracker::start();
         tcpu.startTimer();
         fft.init_inverse();
         result.setValue(RecordType::PlanInitInv, tcpu.stopTimer());
+        allocations(result, RecordType::AllocPlanBytes, RecordType::AllocPlanCount);
+        memory(result, RecordType::MemoryPlanInitInv, rss);
       }
+    }
+
+    /**
+     * Upload, forward and inverse transform and download.
+     * If setup is true, memory is allocated and plans are created before,
+     * otherwise the setup records are set to zero.
+     * With inner repetition the counts are calibrated after the first upload,
+     * the transforms are timed per execution and the round trip is repeated
+     * once after the timed transforms (not timed), so the download can be validated.
+     */
+    template<typename T_Result, typename T_ClientImpl, typename T_Vector>
+    static void run(T_Result& result, T_ClientImpl& fft, T_Vector& vec, bool setup, InnerRepetition& inner) {
+      TimerCPU tcpu;
+      T_DeviceTimer tdev;
+      PerfCounters& perf = PerfCounters::get(); // no-op if not enabled
+      OsNoise& noise = OsNoise::get(); // no-op if not enabled
+      noise.clear();
+
+      result.setValue(RecordType::FlushTime, 0.0);
+
+      result.setValue(RecordType::DevBufferSize, fft.get_allocation_size());
+      result.setValue(RecordType::DevPlanSize, fft.get_plan_size());
+      result.setValue(RecordType::DevTransferSize, fft.get_transfer_size());
+
+      if(setup) {
+        allocate_and_plan(result, fft, !T_ReusePlan::value);
+      } else {
+        result.setValue(RecordType::Allocation, 0.0);
+        result.setValue(RecordType::PlanInitFwd, 0.0);
+        result.setValue(RecordType::PlanInitInv, 0.0);
+        result.setValue(RecordType::MemoryAllocation, 0.0);
+        result.setValue(RecordType::MemoryPlanInitFwd, 0.0);
+        result.setValue(RecordType::MemoryPlanInitInv, 0.0);
+      }
+
+      prime(result, fft, vec);
+      const size_t rss_execute = MemoryUsage::rss();
 
       // upload data
+      noise.start();
+      perf.start();
       tdev.startTimer();
       fft.upload(vec.data());
       result.setValue(RecordType::Upload, tdev.stopTimer());
+      perf.stop(result, RecordType::PerfUploadCycles);
+      noise.stop();
+
+      size_t reps_fft = 1;
+      size_t reps_ifft = 1;
+      // repeated transforms restore their input between chunks, so their data cannot overflow
+      using RealT = typename Precision<typename T_Vector::value_type, T_FFT::IsComplex>::type;
+      const size_t chunk = InnerRepetition::maxChunk<RealT>(vec.size());
+      auto restore_forward = [&fft, &vec]() { fft.upload(vec.data()); };
+      auto restore_inverse = [&fft, &vec]() { fft.upload(vec.data()); fft.execute_forward(); };
+      if(InnerRepetition::isEnabled()) {
+        if(!inner.isCalibrated()) {
+          SCOREP_USER_REGION("inner_calibration", SCOREP_USER_REGION_TYPE_DYNAMIC)
+          inner.calibrate(tdev, chunk,
+                          [&fft]() { fft.execute_forward(); },
+                          [&fft]() { fft.execute_inverse(); },
+                          restore_forward, restore_inverse);
+          fft.upload(vec.data()); // restore input
+        }
+        reps_fft = inner.countFFT();
+        reps_ifft = inner.countFFTInv();
+        result.setValue(RecordType::InnerRepetitionsFFT, static_cast<double>(reps_fft));
+        result.setValue(RecordType::InnerRepetitionsFFTInv, static_cast<double>(reps_ifft));
+      }
 
       {
-        FLUSH();
+        flush(result);
         SCOREP_USER_REGION("transform_forward", SCOREP_USER_REGION_TYPE_DYNAMIC)
         // execute forward transform
-        tdev.startTimer();
-        fft.execute_forward();
-        result.setValue(RecordType::FFT, tdev.stopTimer());
+        noise.start();
+        AllocTracker::start();
+        perf.start();
+        result.setValue(RecordType::FFT,
+                        inner.time(tdev, reps_fft, chunk,
+                                   [&fft]() { fft.execute_forward(); }, restore_forward));
+        perf.stop(result, RecordType::PerfFFTCycles, reps_fft);
+        allocations(result, RecordType::AllocExecuteBytes, RecordType::AllocExecuteCount);
+        noise.stop();
       }
 
-      if(T_ReusePlan::value) {
-        FLUSH();
+      if(setup && T_ReusePlan::value) {
+        flush(result);
         SCOREP_USER_REGION("plan_backward_reuse", SCOREP_USER_REGION_TYPE_DYNAMIC)
         // init inverse plan
+        size_t rss = MemoryUsage::rss();
+        AllocTracker::start();
         tcpu.startTimer();
         fft.init_inverse();
         result.setValue(RecordType::PlanInitInv, tcpu.stopTimer());
+        allocations(result, RecordType::AllocPlanBytes, RecordType::AllocPlanCount);
+        memory(result, RecordType::MemoryPlanInitInv, rss);
       }
 
+      if(reps_fft > 1) // the inverse starts from the output of one forward transform
+        restore_inverse();
+
       {
-        FLUSH();
+        flush(result);
         SCOREP_USER_REGION("transform_backward", SCOREP_USER_REGION_TYPE_DYNAMIC)
         // execute inverse transform
-        tdev.startTimer();
+        noise.start();
+        AllocTracker::start();
+        perf.start();
+        result.setValue(RecordType::FFTInv,
+                        inner.time(tdev, reps_ifft, chunk,
+                                   [&fft]() { fft.execute_inverse(); }, restore_inverse));
+        perf.stop(result, RecordType::PerfFFTInvCycles, reps_ifft);
+        allocations(result, RecordType::AllocExecuteBytes, RecordType::AllocExecuteCount);
+        noise.stop();
+      }
+
+      if(reps_fft > 1 || reps_ifft > 1) {
+        // repeated transforms do not leave the round trip in the buffers
+        fft.upload(vec.data());
+        fft.execute_forward();
         fft.execute_inverse();
-        result.setValue(RecordType::FFTInv, tdev.stopTimer());
+      }
+
+      if(LatencySampler::getSamples() > 0) {
+        SCOREP_USER_REGION("latency", SCOREP_USER_REGION_TYPE_DYNAMIC)
+        latency(result, fft, vec, tdev);
       }
 
       // download data
+      noise.start();
+      perf.start();
       tdev.startTimer();
       fft.download(vec.data());
       result.setValue(RecordType::Download, tdev.stopTimer());
+      perf.stop(result, RecordType::PerfDownloadCycles);
+      noise.stop();
+      noise.store(result);
+
+      // the inverse plan of libraries reusing the plan is created in between
+      memory(result, RecordType::MemoryExecute, rss_execute);
+      if(setup && T_ReusePlan::value && MemoryUsage::isEnabled())
+        result.setValue(RecordType::MemoryExecute,
+                        result.getValue(RecordType::MemoryExecute) - result.getValue(RecordType::MemoryPlanInitInv));
+    }
 
-      /// --- Cleanup ---
-      tcpu.startTimer();
-      fft.destroy();
-      result.setValue(RecordType::PlanDestroy, tcpu.stopTimer());
+    /// records the change of the resident set size since rss if --memory is given (not timed)
+    template<typename T_Result>
+    static void memory(T_Result& result, RecordType record, size_t rss) {
+      if(!MemoryUsage::isEnabled())
+        return;
+      result.setValue(record, static_cast<double>(MemoryUsage::rss()) - static_cast<double>(rss));
+    }
 
-      result.setValue(RecordType::Total, tcpu_total.stopTimer());
+    /**
+     * Adds the heap allocations since AllocTracker::start() to the records
+     * if --track-allocs is given (not timed), count may be null.
+     * The records of a run start at zero, so phases accumulate.
+     */
+    template<typename T_Result>
+    static void allocations(T_Result& result, RecordType bytes, const RecordType* count) {
+      if(!AllocTracker::isEnabled())
+        return;
+      AllocTracker::Counts counts = AllocTracker::stop();
+      result.setValue(bytes, result.getValue(bytes) + counts.bytes);
+      if(count)
+        result.setValue(*count, result.getValue(*count) + counts.allocations);
+    }
 
+    template<typename T_Result>
+    static void allocations(T_Result& result, RecordType bytes, RecordType count) {
+      allocations(result, bytes, &count);
+    }
 
+    /// records the peak resident set size of the run if --memory is given
+    template<typename T_Result>
+    static void memory_peak(T_Result& result) {
+      if(!MemoryUsage::isEnabled())
+        return;
+      result.setValue(RecordType::MemoryPeak, static_cast<double>(MemoryUsage::peak()));
     }
 
-    static constexpr std::size_t flushBufferSize = 4 * GEARSHIFFT_FLUSH_LLC_SIZE_MEBIBYTES * (1 << 20);
-    static constexpr std::size_t flushStride     =     GEARSHIFFT_FLUSH_CL_SIZE_BYTES;
-    static std::unique_ptr<volatile char[]> flushBuffer;  // no std::byte in C++14
-    static volatile char flushSink;
+    /// evicts the caches if enabled (--flush-cache), the time is added to Time_Flush
+    template<typename T_Result>
+    static void flush(T_Result& result) {
+      if(!CacheFlush::isEnabled())
+        return;
+      double time = CacheFlush::get()();
+      result.setValue(RecordType::FlushTime, result.getValue(RecordType::FlushTime) + time);
+    }
 
-    static void flush() {
-      std::iota(flushBuffer.get(), flushBuffer.get() + flushBufferSize, 0x0);
-      for (std::size_t i = 0; i < flushBufferSize; i += flushStride) {
-        flushSink += flushBuffer[i];
+    /**
+     * Buffer ring (--buffer-ring): clients providing prime() fill all buffer
+     * pairs with the input before the first upload (not timed).
+     */
+    template<typename T_Result, typename T_ClientImpl, typename T_Vector>
+    static void prime(T_Result& result, T_ClientImpl& fft, T_Vector& vec) {
+      if(!BufferRing::isEnabled())
+        return;
+      result.setValue(RecordType::RingBuffers, client_prime(fft, vec.data(), 0));
+    }
+
+    /// returns the number of buffer pairs, NaN if the client has no buffer ring
+    template<typename T_ClientImpl, typename T_Data>
+    static auto client_prime(T_ClientImpl& fft, T_Data* data, int) -> decltype(static_cast<double>(fft.prime(data))) {
+      return static_cast<double>(fft.prime(data));
+    }
+
+    template<typename T_ClientImpl, typename T_Data>
+    static double client_prime(T_ClientImpl&, T_Data*, long) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /// page sizes of client and host buffers if --hugepages is given (not timed)
+    template<typename T_Result, typename T_ClientImpl, typename T_Vector>
+    static void page_sizes(T_Result& result, T_ClientImpl& fft, const T_Vector& vec) {
+      if(!HugePages::isReported())
+        return;
+      result.setValue(RecordType::PageSizeDevice, client_page_size(fft, 0));
+      result.setValue(RecordType::PageSizeHost, HugePages::pageSize(vec.data()));
+    }
+
+    /**
+     * Wisdom cache (--wisdom_cache): clients may provide a static export_wisdom(),
+     * called once per benchmark after the last run (not timed in Total),
+     * returning the export time [ms].
+     */
+    template<typename T_ClientImpl>
+    static auto client_export_wisdom(int) -> decltype(static_cast<double>(T_ClientImpl::export_wisdom())) {
+      return static_cast<double>(T_ClientImpl::export_wisdom());
+    }
+
+    template<typename T_ClientImpl>
+    static double client_export_wisdom(long) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /// clients may provide get_page_size() of their buffers
+    template<typename T_ClientImpl>
+    static auto client_page_size(T_ClientImpl& fft, int) -> decltype(static_cast<double>(fft.get_page_size())) {
+      return static_cast<double>(fft.get_page_size());
+    }
+
+    template<typename T_ClientImpl>
+    static double client_page_size(T_ClientImpl&, long) {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    /**
+     * Latency mode, each sample re-uploads the data (not timed) and records
+     * forward and inverse execution time [ns] into the histograms.
+     */
+    template<typename T_Result, typename T_ClientImpl, typename T_Vector>
+    static void latency(T_Result& result, T_ClientImpl& fft, T_Vector& vec, T_DeviceTimer& tdev) {
+      auto& sampler = LatencySampler::get();
+      auto& hfft = sampler.fft();
+      auto& hifft = sampler.ifft();
+      const size_t samples = LatencySampler::getSamples();
+      sampler.clear();
+      for(size_t i = 0; i < samples; ++i) {
+        fft.upload(vec.data());
+        tdev.startTimer();
+        fft.execute_forward();
+        hfft.record(static_cast<uint64_t>(tdev.stopTimer() * 1.0e6));
+        tdev.startTimer();
+        fft.execute_inverse();
+        hifft.record(static_cast<uint64_t>(tdev.stopTimer() * 1.0e6));
       }
+      sampler.store(result);
     }
   };
 
-#ifdef GEARSHIFFT_FLUSH_CACHE
-  template<typename T_FFT,
-           typename T_ReusePlan,
-           template <typename,typename,size_t,typename... > class T_Client,
-           typename T_DeviceTimer,
-           typename... T_ClientArgs>
-  std::unique_ptr<volatile char[]>
-  FFT<T_FFT, T_ReusePlan, T_Client, T_DeviceTimer, T_ClientArgs...>::flushBuffer =
-      std::make_unique<volatile char[]>(flushBufferSize);
-
-  template<typename T_FFT,
-           typename T_ReusePlan,
-           template <typename,typename,size_t,typename... > class T_Client,
-           typename T_DeviceTimer,
-           typename... T_ClientArgs>
-  volatile char FFT<T_FFT, T_ReusePlan, T_Client, T_DeviceTimer, T_ClientArgs...>::flushSink = 'X';
-#endif
-
 }
 #endif /* FFT_HPP_ */
@@ -0,0 +1,335 @@
+#ifndef HUGE_PAGES_HPP_
+#define HUGE_PAGES_HPP_
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wold-style-cast"
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <boost/align/aligned_alloc.hpp>
+#pragma GCC diagnostic pop
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Huge page backed buffers (--hugepages).
+   *
+   * - off: default allocation (aligned heap memory)
+   * - thp: 2 MiB aligned memory advised as transparent huge pages (madvise(MADV_HUGEPAGE))
+   * - hugetlb-2M, hugetlb-1G: mmap(MAP_HUGETLB) from the reserved pool
+   *   (/sys/kernel/mm/hugepages), falls back to thp if no pages are available.
+   *
+   * Used for the host buffers (see BenchmarkData) and the FFTW buffers.
+   * The kernel decides whether THP are actually used, so pageSize() reads the
+   * page size backing a buffer from /proc/self/smaps.
+   */
+  class HugePages {
+  public:
+    enum class Mode { Off, THP, HugeTLB2M, HugeTLB1G };
+
+    static constexpr size_t SIZE_2M = size_t(1) << 21;
+    static constexpr size_t SIZE_1G = size_t(1) << 30;
+
+    static bool isValidMode(const std::string& mode) {
+      return mode=="off" || mode=="thp" || mode=="hugetlb-2M" || mode=="hugetlb-1G";
+    }
+
+    /// \param report page sizes are recorded by the benchmarks (see isReported())
+    static void configure(const std::string& mode, bool report) {
+      reported_() = report;
+      if(mode=="thp")
+        mode_() = Mode::THP;
+      else if(mode=="hugetlb-2M")
+        mode_() = Mode::HugeTLB2M;
+      else if(mode=="hugetlb-1G")
+        mode_() = Mode::HugeTLB1G;
+      else
+        mode_() = Mode::Off;
+    }
+
+    static Mode mode() {
+      return mode_();
+    }
+
+    static bool enabled() {
+      return mode_() != Mode::Off;
+    }
+
+    static bool isReported() {
+      return reported_();
+    }
+
+    /// allocates bytes with the configured mode, throws std::bad_alloc
+    static void* allocate(size_t bytes, size_t alignment) {
+      if(bytes==0)
+        return nullptr;
+      void* p = nullptr;
+#ifdef __linux__
+      switch(mode_()) {
+      case Mode::HugeTLB1G:
+        p = mapHugeTLB(bytes, SIZE_1G, 30);
+        if(p)
+          break;
+        // fall through
+      case Mode::HugeTLB2M:
+        p = mapHugeTLB(bytes, SIZE_2M, 21);
+        if(p)
+          break;
+        // fall through
+      case Mode::THP:
+        p = allocTHP(bytes);
+        break;
+      case Mode::Off:
+        break;
+      }
+#endif
+      if(p==nullptr) {
+        p = boost::alignment::aligned_alloc(alignment, bytes);
+        if(p==nullptr)
+          throw std::bad_alloc();
+      }
+      return p;
+    }
+
+    static void deallocate(void* p) {
+      if(p==nullptr)
+        return;
+#ifdef __linux__
+      {
+        std::lock_guard<std::mutex> lock(mutex_());
+        auto it = blocks_().find(p);
+        if(it != blocks_().end()) {
+          size_t length = it->second.length;
+          bool mapped = it->second.mapped;
+          blocks_().erase(it);
+          if(mapped)
+            munmap(p, length);
+          else
+            std::free(p);
+          return;
+        }
+      }
+#endif
+      boost::alignment::aligned_free(p);
+    }
+
+    /**
+     * Page size [bytes] backing most of the resident memory of the mapping containing p,
+     * NaN if unknown.  Transparent huge pages count as huge page size.
+     */
+    static double pageSize(const void* p) {
+      const double nan = std::numeric_limits<double>::quiet_NaN();
+#ifdef __linux__
+      if(p==nullptr)
+        return nan;
+      const uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+      std::ifstream smaps("/proc/self/smaps");
+      std::string line;
+      bool found = false;
+      double kernelPage = nan;
+      double rss = 0.0;
+      double anonHuge = 0.0;
+      while(std::getline(smaps, line)) {
+        uintptr_t begin = 0, end = 0;
+        char dash = 0;
+        std::istringstream ss(line);
+        if(line.find(':') == std::string::npos || line.find('-') < line.find(':')) {
+          // mapping header "begin-end perms ..."
+          if(found)
+            break;
+          if(ss >> std::hex >> begin >> dash >> end && dash=='-')
+            found = begin <= addr && addr < end;
+          continue;
+        }
+        if(!found)
+          continue;
+        std::string key;
+        double kb = 0.0;
+        ss >> key >> kb;
+        if(key=="Rss:")
+          rss = kb;
+        else if(key=="AnonHugePages:")
+          anonHuge = kb;
+        else if(key=="KernelPageSize:")
+          kernelPage = 1024.0 * kb;
+      }
+      if(!found)
+        return nan;
+      if(anonHuge > 0.0 && 2.0*anonHuge >= rss)
+        return static_cast<double>(thpSize());
+      return kernelPage;
+#else
+      (void)p;
+      return nan;
+#endif
+    }
+
+    /// csv meta information on the configured mode and the huge page pools
+    static std::string properties() {
+      std::ostringstream msg;
+      msg << ",\"HugePages\",\"" << modeStr() << "\"";
+#ifdef __linux__
+      msg << ",\"THP\",\"" << readLine("/sys/kernel/mm/transparent_hugepage/enabled") << "\""
+          << ",\"HugePages_2M_Free\"," << freePages("hugepages-2048kB")
+          << ",\"HugePages_1G_Free\"," << freePages("hugepages-1048576kB");
+#endif
+      return msg.str();
+    }
+
+  private:
+    struct Block {
+      size_t length;
+      bool mapped;
+    };
+
+    static Mode& mode_() {
+      static Mode mode = Mode::Off;
+      return mode;
+    }
+
+    static bool& reported_() {
+      static bool reported = false;
+      return reported;
+    }
+
+    // never destroyed, buffers of static objects (BenchmarkData) are freed at exit
+    static std::map<void*, Block>& blocks_() {
+      static auto* blocks = new std::map<void*, Block>();
+      return *blocks;
+    }
+
+    static std::mutex& mutex_() {
+      static auto* m = new std::mutex();
+      return *m;
+    }
+
+    static const char* modeStr() {
+      switch(mode_()) {
+      case Mode::THP: return "thp";
+      case Mode::HugeTLB2M: return "hugetlb-2M";
+      case Mode::HugeTLB1G: return "hugetlb-1G";
+      case Mode::Off: break;
+      }
+      return "off";
+    }
+
+    static std::string readLine(const std::string& file) {
+      std::ifstream ifs(file);
+      std::string line;
+      std::getline(ifs, line);
+      return line;
+    }
+
+    static long freePages(const std::string& pool) {
+      std::string line = readLine("/sys/kernel/mm/hugepages/"+pool+"/free_hugepages");
+      return line.empty() ? 0 : std::stol(line);
+    }
+
+    static size_t thpSize() {
+      std::string line = readLine("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+      return line.empty() ? SIZE_2M : std::stoul(line);
+    }
+
+    static size_t roundUp(size_t bytes, size_t page) {
+      return (bytes + page - 1) / page * page;
+    }
+
+    static void add(void* p, size_t length, bool mapped) {
+      std::lock_guard<std::mutex> lock(mutex_());
+      blocks_()[p] = Block{length, mapped};
+    }
+
+    /// prints the warning once, every fallback has its own flag
+    static void warn(bool& warned, const std::string& what) {
+      std::lock_guard<std::mutex> lock(mutex_());
+      if(warned)
+        return;
+      warned = true;
+      std::cerr << "gearshifft: " << what << '\n';
+    }
+
+#ifdef __linux__
+    static void* mapHugeTLB(size_t bytes, size_t page, int shift) {
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+      size_t length = roundUp(bytes, page);
+      int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT);
+      void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+      if(p == MAP_FAILED) {
+        static bool warned1G = false;
+        static bool warned2M = false;
+        warn(page==SIZE_1G ? warned1G : warned2M,
+             std::string("no huge pages of ") + (page==SIZE_1G ? "1G" : "2M")
+             + " available (mmap: " + std::strerror(errno) + "), falling back"
+             + (page==SIZE_1G ? "." : " to transparent huge pages."));
+        return nullptr;
+      }
+      add(p, length, true);
+      return p;
+#else
+      (void)bytes; (void)page; (void)shift;
+      return nullptr;
+#endif
+    }
+
+    static void* allocTHP(size_t bytes) {
+      const size_t page = thpSize();
+      size_t length = roundUp(bytes, page);
+      void* p = nullptr;
+      if(posix_memalign(&p, page, length) != 0)
+        return nullptr;
+#ifdef MADV_HUGEPAGE
+      static bool warned = false;
+      if(madvise(p, length, MADV_HUGEPAGE) != 0)
+        warn(warned, std::string("madvise(MADV_HUGEPAGE) failed: ") + std::strerror(errno));
+#endif
+      add(p, length, false);
+      return p;
+    }
+#endif
+  };
+
+  /// std allocator using HugePages, see BenchmarkData
+  template<typename T>
+  struct HugePageAllocator {
+    using value_type = T;
+
+    HugePageAllocator() = default;
+    template<typename U>
+    HugePageAllocator(const HugePageAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(HugePages::allocate(n*sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, size_t) {
+      HugePages::deallocate(p);
+    }
+
+    template<typename U>
+    struct rebind { using other = HugePageAllocator<U>; };
+  };
+
+  template<typename T, typename U>
+  bool operator==(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return true; }
+  template<typename T, typename U>
+  bool operator!=(const HugePageAllocator<T>&, const HugePageAllocator<U>&) { return false; }
+
+} // gearshifft
+
+#endif /* HUGE_PAGES_HPP_ */
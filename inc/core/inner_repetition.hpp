@@ -0,0 +1,175 @@
+#ifndef INNER_REPETITION_HPP_
+#define INNER_REPETITION_HPP_
+
+#include "alloc_tracker.hpp"
+#include "os_noise.hpp"
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace gearshifft {
+
+  /**
+   * Calibrated inner repetition (--inner-time) for transforms too short to be timed once.
+   *
+   * Before the first timed execution of a benchmark, calibrate() determines
+   * for forward and inverse transform how many back-to-back executions take at
+   * least the minimum time.  The timed steps then execute this number of
+   * transforms and the time per transform is recorded.
+   * Repeated transforms read the output of the previous one, unnormalized
+   * transforms grow single elements by up to n per execution.  The
+   * executions are therefore split into chunks (see maxChunk()) and the input
+   * is restored between the chunks, the restore is neither timed nor counted
+   * by the perf counters, the OS noise or the allocation tracking.  Each chunk
+   * is timed on its own, so the overhead of an empty start/stop pair of the
+   * timer is calibrated once and subtracted per chunk.
+   * One instance per benchmark (see FFT), the counts are kept for all runs.
+   */
+  class InnerRepetition {
+  public:
+    /// upper limit of the executions per timed step
+    static constexpr size_t MAX_COUNT = size_t(1) << 24;
+
+    /// empty start/stop pairs of the overhead calibration
+    static constexpr int OVERHEAD_SAMPLES = 100;
+
+    /// minimum time [ms] of a timed step, 0 disables inner repetition
+    static void enable(double minTime) {
+      minTime_() = minTime;
+    }
+
+    static bool isEnabled() {
+      return minTime_() > 0.0;
+    }
+
+    static double getMinTime() {
+      return minTime_();
+    }
+
+    bool isCalibrated() const {
+      return countFFT_ > 0;
+    }
+
+    size_t countFFT() const {
+      return countFFT_;
+    }
+
+    size_t countFFTInv() const {
+      return countFFTInv_;
+    }
+
+    /// time [ms] of an empty start/stop pair of the timer, subtracted per chunk
+    double overhead() const {
+      return overhead_;
+    }
+
+    /**
+     * Maximum executions per chunk for unnormalized transforms of n elements,
+     * which keeps the growth of the data (up to n per execution) within half of
+     * the exponent range of T_Real.
+     */
+    template<typename T_Real>
+    static size_t maxChunk(size_t n) {
+      if(n < 2)
+        return MAX_COUNT;
+      double k = std::numeric_limits<T_Real>::max_exponent / (2.0 * std::log2(static_cast<double>(n)));
+      return static_cast<size_t>(std::max(1.0, std::min(k, static_cast<double>(MAX_COUNT))));
+    }
+
+    /**
+     * Calibrates the counts with the device timer of the benchmark (not recorded).
+     * \param chunk maximum executions between two restores, see maxChunk()
+     * \param forward,inverse execute one transform
+     * \param restore_forward,restore_inverse restore the input of the transform
+     */
+    template<typename T_Timer, typename T_Forward, typename T_Inverse,
+             typename T_RestoreForward, typename T_RestoreInverse>
+    void calibrate(T_Timer& timer, size_t chunk,
+                   T_Forward&& forward, T_Inverse&& inverse,
+                   T_RestoreForward&& restore_forward, T_RestoreInverse&& restore_inverse) {
+      overhead_ = calibrateOverhead(timer);
+      countFFT_ = count(timer, chunk, forward, restore_forward);
+      countFFTInv_ = count(timer, chunk, inverse, restore_inverse);
+    }
+
+    /// executes f count times, returns the elapsed time [ms] per execution without the timer overhead
+    template<typename T_Timer, typename T_Function>
+    double time(T_Timer& timer, size_t count, T_Function&& f) const {
+      timer.startTimer();
+      for(size_t i = 0; i < count; ++i)
+        f();
+      return std::max(0.0, timer.stopTimer() - overhead_) / static_cast<double>(count);
+    }
+
+    /**
+     * Executes f count times in chunks of at most chunk executions, returns the
+     * elapsed time [ms] per execution.  restore is called between the chunks,
+     * the perf counters and OS noise of the calling thread and the allocation
+     * tracking are paused meanwhile.
+     */
+    template<typename T_Timer, typename T_Function, typename T_Restore>
+    double time(T_Timer& timer, size_t count, size_t chunk, T_Function&& f, T_Restore&& restore) const {
+      double elapsed = 0.0;
+      for(size_t done = 0; done < count; done += chunk) {
+        if(done > 0) {
+          PerfCounters& perf = PerfCounters::get();
+          OsNoise& noise = OsNoise::get();
+          perf.pause();
+          noise.pause();
+          AllocTracker::pause();
+          restore();
+          AllocTracker::resume();
+          noise.resume();
+          perf.resume();
+        }
+        size_t n = std::min(chunk, count - done);
+        elapsed += time(timer, n, f) * static_cast<double>(n);
+      }
+      return elapsed / static_cast<double>(count);
+    }
+
+  private:
+    size_t countFFT_ = 0;
+    size_t countFFTInv_ = 0;
+    double overhead_ = 0.0;
+
+    static double& minTime_() {
+      static double minTime = 0.0;
+      return minTime;
+    }
+
+    /// minimum time [ms] of empty start/stop pairs
+    template<typename T_Timer>
+    static double calibrateOverhead(T_Timer& timer) {
+      double overhead = std::numeric_limits<double>::max();
+      for(int i = 0; i < OVERHEAD_SAMPLES; ++i) {
+        timer.startTimer();
+        overhead = std::min(overhead, timer.stopTimer());
+      }
+      return overhead;
+    }
+
+    /// grows the count by the missing time factor (x10 at most per step) until the minimum time is reached
+    template<typename T_Timer, typename T_Function, typename T_Restore>
+    size_t count(T_Timer& timer, size_t chunk, T_Function&& f, T_Restore&& restore) const {
+      const double target = getMinTime();
+      size_t n = 1;
+      while(n < MAX_COUNT) {
+        restore();
+        double t = time(timer, n, chunk, f, restore) * static_cast<double>(n);
+        if(t >= target)
+          break;
+        double factor = t > 0.0 ? std::min(10.0, 1.4 * target / t) : 10.0;
+        n = std::min(MAX_COUNT,
+                     std::max(n + 1, static_cast<size_t>(std::ceil(static_cast<double>(n) * factor))));
+      }
+      return n;
+    }
+  };
+
+} // gearshifft
+
+#endif /* INNER_REPETITION_HPP_ */
@@ -0,0 +1,203 @@
+#ifndef LATENCY_HISTOGRAM_HPP_
+#define LATENCY_HISTOGRAM_HPP_
+
+#include "types.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace gearshifft {
+
+  /**
+   * Log-bucketed latency histogram (HDR-style) of nanosecond values.
+   *
+   * Values below 2^SUB_BITS are counted exactly, above each power of two is
+   * divided into 2^(SUB_BITS-1) sub-buckets, so the relative bucket width is
+   * below 2^(1-SUB_BITS) (< 1.6%).  All buckets are allocated by the constructor,
+   * record() does not allocate.
+   */
+  class LatencyHistogram {
+  public:
+    static constexpr unsigned SUB_BITS = 7;
+    static constexpr uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+    static constexpr uint64_t HALF_COUNT = SUB_COUNT / 2;
+    static constexpr size_t NR_BUCKETS = (64 - SUB_BITS + 1) * HALF_COUNT + HALF_COUNT;
+
+    LatencyHistogram() : counts_(NR_BUCKETS, 0) {}
+
+    void record(uint64_t ns) {
+      ++counts_[index(ns)];
+      ++total_;
+      max_ = std::max(max_, ns);
+    }
+
+    void clear() {
+      std::fill(counts_.begin(), counts_.end(), 0);
+      total_ = 0;
+      max_ = 0;
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+    const std::vector<uint64_t>& counts() const { return counts_; }
+
+    /// highest value equivalent to the bucket containing the p-quantile (0<p<=1)
+    uint64_t percentile(double p) const {
+      if(total_ == 0)
+        return 0;
+      uint64_t rank = static_cast<uint64_t>(std::ceil(p * static_cast<double>(total_)));
+      rank = std::max<uint64_t>(1, std::min(rank, total_));
+      uint64_t sum = 0;
+      for(size_t i = 0; i < NR_BUCKETS; ++i) {
+        sum += counts_[i];
+        if(sum >= rank)
+          return std::min(upper(i), max_);
+      }
+      return max_;
+    }
+
+    static size_t index(uint64_t v) {
+      if(v < SUB_COUNT)
+        return static_cast<size_t>(v);
+      unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(v));
+      unsigned shift = msb - (SUB_BITS - 1);
+      return static_cast<size_t>(shift * HALF_COUNT + (v >> shift));
+    }
+
+    /// lowest value of bucket i
+    static uint64_t lower(size_t i) {
+      if(i < SUB_COUNT)
+        return i;
+      uint64_t shift = i / HALF_COUNT - 1;
+      uint64_t m = i - shift * HALF_COUNT;
+      return m << shift;
+    }
+
+    /// highest value of bucket i
+    static uint64_t upper(size_t i) {
+      if(i < SUB_COUNT)
+        return i;
+      uint64_t shift = i / HALF_COUNT - 1;
+      uint64_t m = i - shift * HALF_COUNT;
+      return ((m + 1) << shift) - 1;
+    }
+
+  private:
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+  };
+
+  /**
+   * Latency mode: forward and inverse transform are executed and timed
+   * getSamples() times per run, each sample is recorded into a histogram.
+   * Percentiles are stored as Latency_* records, the full histograms can be
+   * written to a csv file (see open()).
+   */
+  class LatencySampler {
+  public:
+    /// number of samples per run, 0 disables latency mode
+    static void enable(size_t samples) {
+      samples_() = samples;
+    }
+
+    static size_t getSamples() {
+      return samples_();
+    }
+
+    /// sampler of the calling thread
+    static LatencySampler& get() {
+      thread_local LatencySampler sampler;
+      return sampler;
+    }
+
+    LatencyHistogram& fft() { return fft_; }
+    LatencyHistogram& ifft() { return ifft_; }
+
+    void clear() {
+      fft_.clear();
+      ifft_.clear();
+    }
+
+    /// stores p50, p90, p99, p99.9 and max [ms] of FFT and iFFT into result
+    template<typename T_Result>
+    void store(T_Result& result) const {
+      store(result, fft_, RecordType::LatencyFFTP50);
+      store(result, ifft_, RecordType::LatencyFFTInvP50);
+    }
+
+    /// opens csv file for the histograms (empty filename disables output)
+    static void open(const std::string& filename) {
+      std::lock_guard<std::mutex> g(fileMutex_());
+      file_().close();
+      if(filename.empty())
+        return;
+      file_().open(filename, std::ofstream::out);
+      if(!file_().good())
+        throw std::runtime_error("Could not open latency histogram file "+filename);
+      file_() << "\"id\",\"run\",\"record\",\"lower [ns]\",\"upper [ns]\",\"count\"\n";
+    }
+
+    /// writes all non-empty buckets of the current histograms
+    void dump(size_t id, int run) const {
+      std::lock_guard<std::mutex> g(fileMutex_());
+      if(!file_().is_open())
+        return;
+      dump(id, run, "FFT", fft_);
+      dump(id, run, "iFFT", ifft_);
+      file_().flush();
+    }
+
+  private:
+    LatencyHistogram fft_;
+    LatencyHistogram ifft_;
+
+    LatencySampler() = default;
+
+    static size_t& samples_() {
+      static size_t samples = 0;
+      return samples;
+    }
+
+    static std::ofstream& file_() {
+      static std::ofstream file;
+      return file;
+    }
+
+    static std::mutex& fileMutex_() {
+      static std::mutex m;
+      return m;
+    }
+
+    template<typename T_Result>
+    static void store(T_Result& result, const LatencyHistogram& h, RecordType first) {
+      static constexpr double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+      int idx = static_cast<int>(first);
+      for(auto q : quantiles) {
+        result.setValue(idx++, 1.0e-6 * static_cast<double>(h.percentile(q)));
+      }
+      result.setValue(idx, 1.0e-6 * static_cast<double>(h.max()));
+    }
+
+    static void dump(size_t id, int run, const char* record, const LatencyHistogram& h) {
+      const auto& counts = h.counts();
+      for(size_t i = 0; i < counts.size(); ++i) {
+        if(counts[i] == 0)
+          continue;
+        file_() << id << ',' << run << ",\"" << record << "\","
+                << LatencyHistogram::lower(i) << ','
+                << LatencyHistogram::upper(i) << ','
+                << counts[i] << '\n';
+      }
+    }
+  };
+
+} // gearshifft
+
+#endif /* LATENCY_HISTOGRAM_HPP_ */
@@ -0,0 +1,101 @@
+#ifndef MEMORY_USAGE_HPP_
+#define MEMORY_USAGE_HPP_
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Resident set size of the process around the benchmark phases (--memory, Linux).
+   *
+   * The RSS is read from /proc/self/statm, pages count when they are touched,
+   * so memory allocated but not yet written shows up in the phase touching it.
+   * The peak is VmHWM of /proc/self/status, reset at the begin of each run by
+   * writing to /proc/self/clear_refs. If the reset is not permitted the peak
+   * refers to the whole process lifetime (MemoryPeakReset in the csv header).
+   * The values are process-wide, concurrent streams and threads of the
+   * FFT library count as well.
+   */
+  class MemoryUsage {
+  public:
+
+    static void enable(bool enabled) {
+      enabled_() = enabled;
+      if(enabled)
+        peakReset_() = resetPeak();
+    }
+
+    static bool isEnabled() {
+      return enabled_();
+    }
+
+    /// current resident set size [bytes], 0 if not enabled or not available
+    static size_t rss() {
+      if(!isEnabled())
+        return 0;
+#ifdef __linux__
+      std::ifstream statm("/proc/self/statm");
+      size_t size = 0, resident = 0;
+      if(statm >> size >> resident)
+        return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+      return 0;
+    }
+
+    /// peak resident set size [bytes] since the last reset, 0 if not available
+    static size_t peak() {
+      if(!isEnabled())
+        return 0;
+      std::ifstream status("/proc/self/status");
+      std::string line;
+      while(std::getline(status, line)) {
+        if(line.compare(0, 6, "VmHWM:") == 0) {
+          std::istringstream value(line.substr(6));
+          size_t kb = 0;
+          value >> kb;
+          return kb * 1024;
+        }
+      }
+      return 0;
+    }
+
+    /// resets the peak to the current RSS, returns false if not permitted
+    static bool resetPeak() {
+      if(!isEnabled())
+        return false;
+      std::ofstream clear("/proc/self/clear_refs");
+      clear << "5";
+      clear.flush();
+      return clear.good();
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      if(isEnabled())
+        msg << ",\"MemoryPeakReset\"," << peakReset_();
+      return msg.str();
+    }
+
+  private:
+    static bool& enabled_() {
+      static bool enabled = false;
+      return enabled;
+    }
+
+    static bool& peakReset_() {
+      static bool reset = false;
+      return reset;
+    }
+  };
+
+} // gearshifft
+
+#endif /* MEMORY_USAGE_HPP_ */
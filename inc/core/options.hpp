@@ -7,9 +7,18 @@
 #include <boost/program_options.hpp>
 #include <boost/core/noncopyable.hpp>
 #pragma GCC diagnostic pop
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#ifndef GEARSHIFFT_NUMBER_WARM_RUNS
+#define GEARSHIFFT_NUMBER_WARM_RUNS 10
+#endif
+
+#ifndef GEARSHIFFT_NUMBER_WARMUPS
+#define GEARSHIFFT_NUMBER_WARMUPS 2
+#endif
+
 namespace gearshifft {
 
   /**
@@ -24,7 +33,7 @@ namespace gearshifft {
   public:
 
     OptionsDefault();
-    ~OptionsDefault();
+    virtual ~OptionsDefault();
 
     bool getHelp() const {
       return help_;
@@ -58,10 +67,205 @@ namespace gearshifft {
       return tag_;
     }
 
+    /// number of devices (threads) of the current benchmark, 0=all
     size_t getNumberDevices() const {
       return ndevices_;
     }
 
+    /// set by the benchmark executor before each benchmark of a --ndevices sweep
+    void setNumberDevices(size_t ndevices) {
+      ndevices_ = ndevices;
+    }
+
+    /// values of --ndevices, one benchmark per value
+    const std::vector<size_t>& getNumberDevicesList() const {
+      return ndevicesList_;
+    }
+
+    /// true if --ndevices is a list of more than one value
+    bool isNumberDevicesSweep() const {
+      return ndevicesList_.size()>1;
+    }
+
+    /**
+     * Planner variants, one benchmark per value.
+     * Libraries with planner settings override this method (see FftwOptions).
+     */
+    virtual std::vector<std::string> getPlanners() const {
+      return {""};
+    }
+
+    /// planner variant of the current benchmark
+    const std::string& getPlanner() const {
+      return planner_;
+    }
+
+    /// set by the benchmark executor before each benchmark
+    void setPlanner(const std::string& planner) {
+      planner_ = planner;
+    }
+
+    /// number of benchmark runs after warmup
+    int getNumberWarmRuns() const {
+      return warmRuns_;
+    }
+
+    int getNumberWarmups() const {
+      return warmups_;
+    }
+
+    /// number of benchmark runs including warmups
+    int getNumberRuns() const {
+      return warmRuns_ + warmups_;
+    }
+
+    /// keep client, memory and plans across all runs of a benchmark
+    bool getSteadyState() const {
+      return steadyState_;
+    }
+
+    /// number of timed executions per run in latency mode (0=disabled)
+    size_t getLatencySamples() const {
+      return static_cast<size_t>(latencySamples_);
+    }
+
+    /// minimum time [ms] of a timed transform step, repeated back-to-back (0=single execution)
+    double getInnerTime() const {
+      return innerTime_;
+    }
+
+    /// csv file for the latency histograms (empty=none)
+    const std::string& getLatencyHistogramFile() const {
+      return latencyHistogramFile_;
+    }
+
+    /// timer of the CPU time measurements (chrono or tsc), see TSC
+    const std::string& getTimer() const {
+      return timer_;
+    }
+
+    /// validation policy of the round trip results, see Validation
+    const std::string& getValidate() const {
+      return validate_;
+    }
+
+    /// input signal of the benchmarks, see DataPattern
+    const std::string& getData() const {
+      return data_;
+    }
+
+    /// seed of the random input signals
+    uint64_t getSeed() const {
+      return seed_;
+    }
+
+    /// flush denormal results to zero (MXCSR), see Denormals
+    bool getFTZ() const {
+      return ftz_;
+    }
+
+    /// treat denormal operands as zero (MXCSR), see Denormals
+    bool getDAZ() const {
+      return daz_;
+    }
+
+    /// evict the caches before plan and execution steps, see CacheFlush
+    bool getFlushCache() const {
+      return flushCache_;
+    }
+
+    /// rotating buffer pairs of the CPU backends (off, auto or number of pairs), see BufferRing
+    const std::string& getBufferRing() const {
+      return bufferRing_;
+    }
+
+    /// read hardware performance counters around upload, FFT, iFFT and download
+    bool getPerfCounters() const {
+      return perfCounters_;
+    }
+
+    /// record the resident set size around the benchmark phases, see MemoryUsage
+    bool getMemory() const {
+      return memory_;
+    }
+
+    /// count context switches, migrations, page faults and interrupts around the execution phases, see OsNoise
+    bool getOsNoise() const {
+      return osNoise_;
+    }
+
+    /// runs with more involuntary context switches, migrations and major faults are flagged
+    double getNoiseThreshold() const {
+      return noiseThreshold_;
+    }
+
+    /// count heap allocations during planning, execution and destroy, see AllocTracker
+    bool getTrackAllocs() const {
+      return trackAllocs_;
+    }
+
+    /**
+     * Directory of the persistent plan cache, empty if disabled.
+     * Libraries supporting it provide the option and override this method (see FftwOptions).
+     */
+    virtual std::string getWisdomCache() const {
+      return "";
+    }
+
+    /// NUMA memory policy (default, local, interleave or node:N), see CpuPlacement
+    const std::string& getNumaPolicy() const {
+      return numaPolicy_;
+    }
+
+    /// thread pinning (none, compact, scatter or cpu list), see CpuPlacement
+    const std::string& getPin() const {
+      return pin_;
+    }
+
+    /// huge page mode (off, thp, hugetlb-2M, hugetlb-1G), see HugePages
+    const std::string& getHugePages() const {
+      return hugePages_;
+    }
+
+    /// true if --hugepages is given, the page sizes are recorded then
+    bool isHugePagesReported() const {
+      return hugePagesReported_;
+    }
+
+    /// target of the relative 95% confidence interval of FFT/iFFT times (0=fixed number of runs)
+    double getTargetCI() const {
+      return targetCI_;
+    }
+
+    bool isAdaptive() const {
+      return targetCI_ > 0.0;
+    }
+
+    /// upper limit of runs (including warmups) in adaptive mode
+    int getMaxRuns() const {
+      return maxRuns_;
+    }
+
+    /// upper limit of time per benchmark in seconds in adaptive mode (0=no limit)
+    double getMaxTime() const {
+      return maxTime_;
+    }
+
+    /// number of transforms executed by one plan (howmany), one benchmark per value
+    const std::vector<size_t>& getBatches() const {
+      return batches_;
+    }
+
+    /// number of concurrent FFT streams, one benchmark per value
+    const std::vector<size_t>& getStreams() const {
+      return streams_;
+    }
+
+    /// true if benchmarks run as concurrent streams (--streams other than 1)
+    bool isStreamsMode() const {
+      return streams_.size()>1 || streams_[0]>1;
+    }
+
     auto add_options() {
       return desc_.add_options();
     }
@@ -70,6 +274,14 @@ namespace gearshifft {
 
     void parseExtent( const std::string& extent );
 
+    void parseBatches( const std::string& batches );
+
+    void parseStreams( const std::string& streams );
+
+    void parseNumberDevices( const std::string& ndevices );
+
+    void parseTargetCI( const std::string& target );
+
     /// processes command line arguments and apply the values to the variables
     int parse(std::vector<char*>&, std::vector<char*>&);
 
@@ -89,6 +301,8 @@ namespace gearshifft {
 
   protected:
 
+    static std::vector<size_t> parseList( const std::string& list, const std::string& name );
+
     template<typename T>
     auto value(T* var) {
       return boost::program_options::value<T>(var);
@@ -96,16 +310,57 @@ namespace gearshifft {
 
   private:
 
+    /// upper limit of --latency, the executions of a run are timed one by one
+    static constexpr int MAX_LATENCY_SAMPLES = 100000000;
+
     std::string outputFile_;
     std::string device_;
     std::string tag_;
+    std::string batch_;
+    std::string streamsStr_;
+    std::string ndevicesStr_;
+    std::string targetCIStr_;
+    std::string latencyHistogramFile_;
+    std::string numaPolicy_;
+    std::string pin_;
+    std::string hugePages_;
+    std::string bufferRing_;
+    std::string timer_;
+    std::string validate_;
+    std::string data_;
+    std::string planner_;
+    uint64_t seed_ = 0;
 
     size_t ndevices_ = 0;
+    int warmRuns_ = GEARSHIFFT_NUMBER_WARM_RUNS;
+    int warmups_ = GEARSHIFFT_NUMBER_WARMUPS;
+    double targetCI_ = 0.0;
+    int maxRuns_ = 100;
+    double maxTime_ = 0.0;
+    std::vector<size_t> batches_ = {1};
+    std::vector<size_t> streams_ = {1};
+    std::vector<size_t> ndevicesList_ = {0};
     bool help_ = false;
     bool verbose_ = false;
     bool version_ = false;
     bool listBenchmarks_ = false;
     bool listDevices_ = false;
+    bool perfCounters_ = false;
+    bool ftz_ = false;
+    bool memory_ = false;
+    bool osNoise_ = false;
+    bool trackAllocs_ = false;
+    bool daz_ = false;
+#ifdef GEARSHIFFT_FLUSH_CACHE
+    bool flushCache_ = true;
+#else
+    bool flushCache_ = false;
+#endif
+    bool hugePagesReported_ = false;
+    bool steadyState_ = false;
+    int latencySamples_ = 0;
+    double innerTime_ = 0.0;
+    double noiseThreshold_ = 0.0;
     char* tmp_ = nullptr;
 
     Extents1DVec vector1D_;
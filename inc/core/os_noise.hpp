@@ -0,0 +1,216 @@
+#ifndef OS_NOISE_HPP_
+#define OS_NOISE_HPP_
+
+#include "types.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Operating system noise around the timed execution phases (--os-noise, Linux).
+   *
+   * Context switches and page faults of the calling thread are read with
+   * getrusage(RUSAGE_THREAD), CPU migrations with the perf software event
+   * (by comparing sched_getcpu() before and after a phase if perf_event_open
+   * is not permitted, which detects at most one migration per phase).
+   * Interrupts are the total of /proc/stat over all CPUs.
+   * The counts are summed over upload, FFT, iFFT and download of a run.
+   * A run is flagged if involuntary context switches, migrations and major
+   * page faults together exceed the threshold, these take the CPU away from
+   * the benchmark thread. Threads of the FFT library are not included.
+   */
+  class OsNoise {
+  public:
+    enum Counter {
+      VoluntarySwitches = 0,
+      InvoluntarySwitches,
+      Migrations,
+      MinorFaults,
+      MajorFaults,
+      Interrupts,
+      NR_COUNTERS
+    };
+    using ValuesT = std::array<uint64_t, NR_COUNTERS>;
+
+    /// enables the counters for all threads, runs with more than threshold events are flagged
+    static void enable(bool enabled, double threshold) {
+      enabled_() = enabled;
+      threshold_() = threshold;
+    }
+
+    static bool isEnabled() {
+      return enabled_();
+    }
+
+    /// counters of the calling thread
+    static OsNoise& get() {
+      thread_local OsNoise noise;
+      return noise;
+    }
+
+    ~OsNoise() {
+#ifdef __linux__
+      if(migrations_ >= 0)
+        ::close(migrations_);
+#endif
+    }
+
+    OsNoise(const OsNoise&) = delete;
+    OsNoise& operator=(const OsNoise&) = delete;
+
+    /// resets the counts of the run
+    void clear() {
+      totals_.fill(0);
+    }
+
+    void start() {
+      if(!isEnabled())
+        return;
+      begin_ = sample();
+#ifdef __linux__
+      cpu_ = sched_getcpu();
+#endif
+      counting_ = true;
+    }
+
+    /// adds the events since start() to the counts of the run
+    void stop() {
+      if(!isEnabled() || !counting_)
+        return;
+      counting_ = false;
+      ValuesT end = sample();
+      for(size_t i = 0; i < NR_COUNTERS; ++i)
+        totals_[i] += end[i] >= begin_[i] ? end[i] - begin_[i] : 0;
+#ifdef __linux__
+      if(migrations_ < 0 && sched_getcpu() != cpu_)
+        ++totals_[Migrations];
+#endif
+    }
+
+    /// suspends counting between start() and stop(), e.g. for untimed work of a timed step
+    void pause() {
+      if(!counting_)
+        return;
+      stop();
+      paused_ = true;
+    }
+
+    /// continues counting after pause()
+    void resume() {
+      if(!paused_)
+        return;
+      paused_ = false;
+      start();
+    }
+
+    /// stores the counts of the run and the flag into result
+    template<typename T_Result>
+    void store(T_Result& result) const {
+      if(!isEnabled())
+        return;
+      for(size_t i = 0; i < NR_COUNTERS; ++i) {
+        result.setValue(static_cast<int>(RecordType::NoiseVoluntarySwitches) + static_cast<int>(i),
+                        static_cast<double>(totals_[i]));
+      }
+      const double events = static_cast<double>(totals_[InvoluntarySwitches]
+                                                + totals_[Migrations]
+                                                + totals_[MajorFaults]);
+      result.setValue(RecordType::NoiseFlagged, events > threshold_() ? 1.0 : 0.0);
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      if(isEnabled()) {
+        msg << ",\"NoiseThreshold\"," << threshold_()
+            << ",\"NoiseMigrations\",\"" << (get().migrations_ >= 0 ? "perf" : "getcpu") << "\"";
+      }
+      return msg.str();
+    }
+
+  private:
+    ValuesT begin_ = { {0} };
+    ValuesT totals_ = { {0} };
+    int migrations_ = -1;
+    int cpu_ = -1;
+    bool counting_ = false;
+    bool paused_ = false;
+
+    OsNoise() {
+#ifdef __linux__
+      if(!isEnabled())
+        return;
+      struct perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_CPU_MIGRATIONS;
+      long fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      if(fd >= 0)
+        migrations_ = static_cast<int>(fd);
+#endif
+    }
+
+    static bool& enabled_() {
+      static bool enabled = false;
+      return enabled;
+    }
+
+    static double& threshold_() {
+      static double threshold = 0.0;
+      return threshold;
+    }
+
+    ValuesT sample() {
+      ValuesT values = { {0} };
+#ifdef __linux__
+      struct rusage usage;
+      if(getrusage(RUSAGE_THREAD, &usage) == 0) {
+        values[VoluntarySwitches] = static_cast<uint64_t>(usage.ru_nvcsw);
+        values[InvoluntarySwitches] = static_cast<uint64_t>(usage.ru_nivcsw);
+        values[MinorFaults] = static_cast<uint64_t>(usage.ru_minflt);
+        values[MajorFaults] = static_cast<uint64_t>(usage.ru_majflt);
+      }
+      if(migrations_ >= 0) {
+        uint64_t count = 0;
+        if(::read(migrations_, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count)))
+          values[Migrations] = count;
+      }
+      values[Interrupts] = interrupts();
+#endif
+      return values;
+    }
+
+    /// total number of interrupts serviced by all CPUs since boot
+    static uint64_t interrupts() {
+      std::ifstream stat("/proc/stat");
+      std::string line;
+      while(std::getline(stat, line)) {
+        if(line.compare(0, 5, "intr ") == 0) {
+          std::istringstream value(line.substr(5));
+          uint64_t total = 0;
+          value >> total;
+          return total;
+        }
+      }
+      return 0;
+    }
+  };
+
+} // gearshifft
+
+#endif /* OS_NOISE_HPP_ */
@@ -0,0 +1,247 @@
+#ifndef PERF_COUNTERS_HPP_
+#define PERF_COUNTERS_HPP_
+
+#include "types.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Hardware performance counters of the calling thread read around a
+   * benchmark phase (Linux perf_event_open).
+   *
+   * The counters (cycles, instructions, LLC misses, dTLB misses, branch misses)
+   * are opened as one group, so they are scheduled together and scaled if the
+   * kernel multiplexes them.  Only user space is counted.  The group is
+   * inherited by threads created after open(), so the benchmark opens it before
+   * the FFT library creates its worker threads (thread pools, OpenMP), which
+   * then count for the benchmark thread.  Values are the difference of reads
+   * at start() and stop(), including workers which exited in between.
+   * Counters which cannot be opened (not supported, perf_event_paranoid,
+   * containers) or which were never scheduled are reported as NaN, the benchmark
+   * itself is not affected.
+   */
+  class PerfCounters {
+  public:
+    static constexpr size_t NR_COUNTERS = 5;
+    using ValuesT = std::array<double, NR_COUNTERS>;
+
+    /// enables the counters for all threads, see get()
+    static void enable(bool enabled) {
+      enabled_() = enabled;
+    }
+
+    static bool isEnabled() {
+      return enabled_();
+    }
+
+    /// counter group of the calling thread, opened on first use
+    static PerfCounters& get() {
+      thread_local PerfCounters counters;
+      return counters;
+    }
+
+    ~PerfCounters() {
+      close();
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /// true if at least one counter could be opened
+    bool available() const {
+      return leader_ >= 0;
+    }
+
+    /**
+     * Opens the group of the calling thread (once), threads created afterwards inherit it.
+     * Called by start(), the benchmark thread calls it before the FFT library creates threads.
+     */
+    void open() {
+      if(!isEnabled() || opened_)
+        return;
+      opened_ = true;
+#ifdef __linux__
+      struct Event { uint32_t type; uint64_t config; };
+      static constexpr uint64_t DTLB_READ_MISS =
+        PERF_COUNT_HW_CACHE_DTLB
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      const Event events[NR_COUNTERS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HW_CACHE, DTLB_READ_MISS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+      };
+      int error = 0;
+      for(size_t i = 0; i < NR_COUNTERS; ++i) {
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = events[i].type;
+        attr.config = events[i].config;
+        attr.disabled = leader_ < 0 ? 1 : 0;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP
+          | PERF_FORMAT_TOTAL_TIME_ENABLED
+          | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        long fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader_, 0);
+        if(fd < 0) {
+          error = errno;
+          continue;
+        }
+        fds_[i] = static_cast<int>(fd);
+        if(leader_ < 0)
+          leader_ = fds_[i];
+      }
+      if(error) {
+        std::cerr << "gearshifft: "
+                  << (available() ? "some hardware counters" : "hardware counters")
+                  << " not available (perf_event_open: " << std::strerror(error)
+                  << "), see /proc/sys/kernel/perf_event_paranoid.\n";
+      }
+#endif
+    }
+
+    void start() {
+      if(!isEnabled())
+        return;
+      open();
+#ifdef __linux__
+      if(available() && read(begin_)) {
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        counting_ = true;
+      }
+#endif
+    }
+
+    /// suspends counting between start() and stop(), e.g. for untimed work of a timed step
+    void pause() {
+#ifdef __linux__
+      if(counting_)
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    /// continues counting after pause()
+    void resume() {
+#ifdef __linux__
+      if(counting_)
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+
+    /// stops counting and returns the counter values (NaN if not available)
+    ValuesT stop() {
+      ValuesT values;
+      values.fill(std::numeric_limits<double>::quiet_NaN());
+      if(!isEnabled() || !counting_)
+        return values;
+      counting_ = false;
+#ifdef __linux__
+      ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      BufferT end = { {0} };
+      if(!read(end))
+        return values;
+      uint64_t nr = end[0];
+      uint64_t enabled = end[1] - begin_[1];
+      uint64_t running = end[2] - begin_[2];
+      double scale = (running > 0 && running < enabled)
+        ? static_cast<double>(enabled) / static_cast<double>(running) : 1.0;
+      for(size_t i = 0, k = 0; i < NR_COUNTERS && k < nr; ++i) {
+        if(fds_[i] < 0)
+          continue;
+        values[i] = running > 0 ? scale * static_cast<double>(end[3 + k] - begin_[3 + k])
+                                : std::numeric_limits<double>::quiet_NaN();
+        ++k;
+      }
+#endif
+      return values;
+    }
+
+    /**
+     * Stops counting and stores the counter values into result.
+     * \param first Record of the first counter of the phase, the other counters follow in order.
+     * \param executions Counter values are divided by the number of executions (inner repetition).
+     */
+    template<typename T_Result>
+    void stop(T_Result& result, RecordType first, size_t executions = 1) {
+      if(!isEnabled())
+        return;
+      ValuesT values = stop();
+      for(size_t i = 0; i < NR_COUNTERS; ++i) {
+        result.setValue(static_cast<int>(first) + static_cast<int>(i),
+                        values[i] / static_cast<double>(executions));
+      }
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      if(isEnabled())
+        msg << ",\"PerfCountersScope\",\"benchmark thread and library threads\"";
+      return msg.str();
+    }
+
+  private:
+    /// layout of PERF_FORMAT_GROUP with enabled/running times
+    using BufferT = std::array<uint64_t, 3 + NR_COUNTERS>;
+
+    std::array<int, NR_COUNTERS> fds_ = { {-1, -1, -1, -1, -1} };
+    int leader_ = -1;
+    BufferT begin_ = { {0} };
+    bool opened_ = false;
+    bool counting_ = false;
+
+    PerfCounters() = default;
+
+    static bool& enabled_() {
+      static bool enabled = false;
+      return enabled;
+    }
+
+    /// reads the group (totals since open(), including exited threads)
+    bool read(BufferT& buffer) const {
+#ifdef __linux__
+      ssize_t bytes = ::read(leader_, buffer.data(), sizeof(buffer));
+      return bytes >= static_cast<ssize_t>(3*sizeof(uint64_t));
+#else
+      (void)buffer;
+      return false;
+#endif
+    }
+
+    void close() {
+#ifdef __linux__
+      for(auto& fd : fds_) {
+        if(fd >= 0)
+          ::close(fd);
+        fd = -1;
+      }
+#endif
+      leader_ = -1;
+      counting_ = false;
+    }
+  };
+
+} // gearshifft
+
+#endif /* PERF_COUNTERS_HPP_ */
@@ -13,15 +13,13 @@
 
 namespace gearshifft {
 
-  template<int T_NumberRuns,  // runs per benchmark including warmup
-           int T_NumberWarmups,
-           int T_NumberValues // recorded values per run
+  template<int T_NumberValues // recorded values per run
            >
   class ResultAll {
 
-    friend class ResultWriter<T_NumberRuns, T_NumberWarmups, T_NumberValues>;
+    friend class ResultWriter<T_NumberValues>;
 
-    using ResultBenchmarkT = ResultBenchmark<T_NumberRuns, T_NumberValues>;
+    using ResultBenchmarkT = ResultBenchmark<T_NumberValues>;
 
   public:
 
@@ -35,7 +33,7 @@ namespace gearshifft {
     }
 
     /*
-     * sort order:  fftkind -> dimkind -> dim -> nx*ny*nz
+     * sort order:  fftkind -> dimkind -> dim -> nx*ny*nz -> config (batch, streams, ndevices, planner)
      */
     void sort() {
       std::lock_guard<std::mutex> g(resultsMutex_);
@@ -51,7 +49,9 @@ namespace gearshifft {
                                          (
                                           lhs.getDim()<rhs.getDim() ||
                                           (lhs.getDim()==rhs.getDim() &&
-                                           lhs.getExtentsTotal()<rhs.getExtentsTotal())
+                                           (lhs.getExtentsTotal()<rhs.getExtentsTotal() ||
+                                            (lhs.getExtentsTotal()==rhs.getExtentsTotal() &&
+                                             lhs.getConfig()<rhs.getConfig())))
                                          ));
               else
                 return lhs.isComplex();
@@ -2,8 +2,11 @@
 #define RESULT_BENCHMARK_HPP_
 
 #include "traits.hpp"
+#include "types.hpp"
 
 #include <math.h>
+#include <algorithm>
+#include <cstddef>
 #include <iostream>
 #include <array>
 #include <vector>
@@ -14,19 +17,27 @@ namespace gearshifft
 {
 
 /** Result data generated after a benchmark has completed the runs
+ *
+ * The values of all runs are stored contiguously, run by run.
+ * The number of runs is set at runtime by init() and can be adjusted
+ * by setNumberRuns() when the benchmark stops early (adaptive mode).
  */
-  template<int T_NumberRuns, int T_NumberValues>
+  template<int T_NumberValues>
   class ResultBenchmark  {
   public:
-    using ValuesT = std::array<std::array<double, T_NumberValues >, T_NumberRuns >;
+    using ValuesT = std::vector<double>;
 
     template<bool isComplex,
              bool isInplace,
              typename T_Precision,
              size_t T_NDim>
-    void init(const std::array<size_t, T_NDim>& ce) {
+    void init(const std::array<size_t, T_NDim>& ce,
+              const BenchmarkConfig& config,
+              int nruns,
+              int nwarmups) {
       static size_t sid = 0;
       id_ = sid++;
+      config_ = config;
       total_ = 1;
       for(size_t i=0; i<T_NDim; ++i) {
         extents_[i] = ce[i];
@@ -35,6 +46,9 @@ namespace gearshifft
       dim_ = T_NDim;
       dimkind_ = computeDimkind();
       run_ = 0;
+      nruns_ = nruns;
+      nwarmups_ = nwarmups;
+      values_.assign(static_cast<size_t>(nruns_) * T_NumberValues, 0.0);
       isInplace_ = isInplace;
       isComplex_ = isComplex;
       precision_ = ToString<T_Precision>::value();
@@ -64,18 +78,34 @@ namespace gearshifft
     /* setters */
 
     void setRun(int run) {
+      assert(run<nruns_);
       run_ = run;
     }
 
+    /// sets all values of the current run to zero (records accumulated over phases start at zero)
+    void clearValues() {
+      std::fill_n(values_.begin() + static_cast<std::ptrdiff_t>(run_) * T_NumberValues, T_NumberValues, 0.0);
+    }
+
     template<typename T_Index>
     void setValue(T_Index idx_val, double val) {
       int idx = static_cast<int>(idx_val);
       assert(idx<T_NumberValues);
-      values_[run_][idx] = val;
+      values_[static_cast<size_t>(run_) * T_NumberValues + idx] = val;
+    }
+
+    /// set actual number of runs (incl. warmups), values of further runs are discarded
+    void setNumberRuns(int nruns, int nwarmups) {
+      assert(nwarmups<=nruns);
+      nruns_ = nruns;
+      nwarmups_ = nwarmups;
+      values_.resize(static_cast<size_t>(nruns_) * T_NumberValues, 0.0);
+      if(run_>=nruns_)
+        run_ = 0;
     }
 
     void setError(int run, const std::string& what) {
-      assert(errorRun_<T_NumberRuns);
+      assert(run<nruns_);
       errorRun_ = run;
       error_ = what;
       // remove path informations of source file location
@@ -90,13 +120,19 @@ namespace gearshifft
     double getValue(T_Index idx_val) const {
       int idx = static_cast<int>(idx_val);
       assert(idx<T_NumberValues);
-      return values_[run_][idx];
+      return values_[static_cast<size_t>(run_) * T_NumberValues + idx];
     }
 
     size_t getID() const {
       return id_;
     }
 
+    /// number of runs including warmups
+    int getNumberRuns() const { return nruns_; }
+    int getNumberWarmups() const { return nwarmups_; }
+    /// number of runs after warmup
+    int getNumberWarmRuns() const { return nruns_ - nwarmups_; }
+
     std::string getPrecision() const { return precision_; }
     size_t getDim() const { return dim_; }
     size_t getDimKind() const { return dimkind_; }
@@ -111,6 +147,21 @@ namespace gearshifft
 
     std::array<size_t,3> getExtents() const { return extents_; }
     size_t getExtentsTotal() const { return total_; }
+    const BenchmarkConfig& getConfig() const { return config_; }
+    size_t getBatch() const { return config_.batch; }
+    size_t getStreams() const { return config_.streams; }
+    size_t getNumberDevices() const { return config_.ndevices; }
+    const std::string& getPlanner() const { return config_.planner; }
+
+    /**
+     * Nominal number of floating point operations of one transform direction
+     * of the whole batch, 5 N log2(N) for complex and half of it for real data.
+     */
+    double getNominalFlops() const {
+      double n = static_cast<double>(total_);
+      double flops = 5.0 * n * log2(n) * static_cast<double>(config_.batch);
+      return isComplex_ ? flops : 0.5 * flops;
+    }
     bool isInplace() const { return isInplace_; }
     bool isComplex() const { return isComplex_; }
     bool hasError() const { return error_.empty()==false; }
@@ -121,6 +172,10 @@ namespace gearshifft
     /// result object id
     size_t id_ = 0;
     int run_ = 0;
+    /// number of runs including warmups
+    int nruns_ = 0;
+    /// number of warmup runs
+    int nwarmups_ = 0;
     /// fft dimension
     size_t dim_ = 0;
     /// extents are 1=Arbitrary, 2=PowerOfTwo, 3=CombRadix357
@@ -129,8 +184,10 @@ namespace gearshifft
     std::array<size_t,3> extents_ = { {1} };
     /// all extents multiplied
     size_t total_ = 1;
-    /// each run w values ( data[idx_run][idx_val] )
-    ValuesT values_ = { {{ {0.0} }} };
+    /// batch size, number of streams and devices, planner
+    BenchmarkConfig config_;
+    /// each run w values ( data[idx_run*w + idx_val] )
+    ValuesT values_;
     /// FFT Kind Inplace
     bool isInplace_ = false;
     /// FFT Kind Complex
@@ -2,9 +2,13 @@
 #define RESULT_WRITER_HPP_
 
 #include "result_benchmark.hpp"
+#include "statistics.hpp"
 
+#include <algorithm>
+#include <array>
 #include <condition_variable>
 #include <cstdio>
+#include <filesystem>
 #include <fstream>
 #include <iomanip>
 #include <ios>
@@ -13,18 +17,19 @@
 #include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
 
 
 namespace gearshifft {
 
-  template<int T_NumberRuns, int T_NumberWarmups, int T_NumberValues>
+  template<int T_NumberValues>
   class ResultAll;
 
-  template<int T_NumberRuns, int T_NumberWarmups, int T_NumberValues>
+  template<int T_NumberValues>
   class ResultWriter {
 
-    using ResultBenchmarkT = ResultBenchmark<T_NumberRuns, T_NumberValues>;
-    using ResultAllT = ResultAll<T_NumberRuns, T_NumberWarmups, T_NumberValues>;
+    using ResultBenchmarkT = ResultBenchmark<T_NumberValues>;
+    using ResultAllT = ResultAll<T_NumberValues>;
 
   public:
 
@@ -32,8 +37,10 @@ namespace gearshifft {
                std::string fname,
                std::string apptitle,
                std::string dev_infos,
+               std::vector<RecordType> records,
                bool verbose) {
       resultAll_ = resultAll;
+      records_   = records;
       fname_     = fname;
       fnameBak_  = fname + BAK_SUFFIX;
       apptitle_  = apptitle;
@@ -69,6 +76,7 @@ namespace gearshifft {
       resultAll_->sort();
       saveCSV();
       std::cout << "\nResults written to " << fname_ << std::endl;
+      savePlannerTable();
 
       std::remove(fnameBak_.c_str()); // delete backup file
     }
@@ -101,6 +109,18 @@ namespace gearshifft {
       No  = false
     };
 
+    /// values derived from the records of a run, see derivedValues()
+    static constexpr int NR_DERIVED = 6;
+    static constexpr const char* DERIVED_TITLES[NR_DERIVED] = {
+      "GFlops_FFT [GFLOP/s]",
+      "GFlops_iFFT [GFLOP/s]",
+      "Bandwidth_FFT [GB/s]",
+      "Bandwidth_iFFT [GB/s]",
+      "Bandwidth_Upload [GB/s]",
+      "Bandwidth_Download [GB/s]"
+    };
+    using DerivedT = std::array<double, NR_DERIVED>;
+
     static constexpr char BAK_SUFFIX[] = "~";
     static constexpr char SEP = ',';
     static constexpr std::streamsize PREC = 11;
@@ -117,6 +137,8 @@ namespace gearshifft {
     std::string fnameBak_;
     std::string apptitle_;
     std::string dev_infos_;
+    /// records written to output (optional record groups may be disabled)
+    std::vector<RecordType> records_;
     std::thread thread_;
     std::mutex writer_mutex_; // for condition_variable update_; mutual exclusion on cursorEnd_, stopLoop_
     std::condition_variable update_;
@@ -167,14 +189,15 @@ namespace gearshifft {
     void headerOut() const {
       std::stringstream ss;
       ss << "; " << dev_infos_ << "\n"
-         << apptitle_ << ", RunsPerBenchmark=" << T_NumberRuns << "\n";
+         << apptitle_ << "\n";
 
       OUT << ss.str() << std::flush;
     }
 
     void resultToStreamOut(std::stringstream& stream,
                            ResultBenchmarkT& result) const {
-      int nruns = T_NumberRuns;
+      int nruns = result.getNumberRuns();
+      int nwarmups = result.getNumberWarmups();
       std::string inplace = result.isInplace() ? "Inplace" : "Outplace";
       std::string complex = result.isComplex() ? "Complex" : "Real";
 
@@ -185,6 +208,11 @@ namespace gearshifft {
              << ", Dim="<<result.getDim()
              << ", Kind="<<result.getDimKindStr()<<" ("<<result.getDimKind()<<")"
              << ", Ext="<<result.getExtents()
+             << ", Batch="<<result.getBatch()
+             << ", Streams="<<result.getStreams()
+             << ", NDevices="<<result.getNumberDevices()
+             << (result.getPlanner().empty() ? "" : ", Planner="+result.getPlanner())
+             << ", Runs="<<nruns-nwarmups<<" (+"<<nwarmups<<" warmups)"
              << "\n";
       if(result.hasError()) {
         stream << " Error at run="<<result.getErrorRun()
@@ -195,18 +223,243 @@ namespace gearshifft {
       stream << std::setfill('-') << std::setw(70) <<"-"<< "\n"
              << std::setfill(' ');
       double sum;
-      for(int ival=0; ival<T_NumberValues; ++ival) {
+      int count = std::max(1, nruns-nwarmups);
+      std::array<double, T_NumberValues> avg = { {0.0} };
+      for(auto record : records_) {
         sum = 0.0;
-        for(int run=T_NumberWarmups; run<nruns; ++run) {
+        RunningStats stats;
+        for(int run=nwarmups; run<nruns; ++run) {
           result.setRun(run);
-          sum += result.getValue(ival);
+          sum += result.getValue(record);
+          stats.add(result.getValue(record));
         }
+        avg[static_cast<size_t>(record)] = sum/count;
         stream << std::setw(28)
-               << static_cast<RecordType>(ival)
-               << ": " << std::setw(16) << sum/(T_NumberRuns-T_NumberWarmups)
-               << " [avg]"
+               << record
+               << ": " << std::setw(16) << sum/count
+               << " [avg]";
+        if(record == RecordType::FFT || record == RecordType::FFTInv) {
+          stream << " +/- " << 100.0*stats.relativeCI() << " % [95% CI]";
+        }
+        stream << "\n";
+      }
+      // derived from average times
+      DerivedT derived = derivedValues(result, [&](RecordType r) {
+          return avg[static_cast<size_t>(r)];
+        });
+      for(int i=0; i<NR_DERIVED; ++i) {
+        stream << std::setw(28)
+               << DERIVED_TITLES[i]
+               << ": " << std::setw(16) << derived[i]
                << "\n";
       }
+      // parallel efficiency T_1/(p*T_p) relative to the single device run
+      ResultBenchmarkT* single = findSingleDevice(result);
+      const size_t p = result.getNumberDevices();
+      if(single && p>1) {
+        for(auto record : {RecordType::FFT, RecordType::FFTInv}) {
+          double t1 = meanValue(*single, record);
+          double tp = avg[static_cast<size_t>(record)];
+          stream << std::setw(28)
+                 << (record==RecordType::FFT ? "Efficiency_FFT" : "Efficiency_iFFT")
+                 << ": " << std::setw(16) << 100.0*t1/(static_cast<double>(p)*tp)
+                 << " % [speedup " << t1/tp << "]\n";
+        }
+      }
+    }
+
+    /**
+     * Successful benchmark with the same FFT kind, precision, extents, batch
+     * and streams as result, but run on a single device (--ndevices sweep).
+     * Caller must hold resultsMutex_.
+     */
+    ResultBenchmarkT* findSingleDevice(const ResultBenchmarkT& result) const {
+      for(auto& other : resultAll_->results_) {
+        if(other.getNumberDevices()==1
+           && !other.hasError()
+           && other.getBatch()==result.getBatch()
+           && other.getStreams()==result.getStreams()
+           && other.getPlanner()==result.getPlanner()
+           && other.isInplace()==result.isInplace()
+           && other.isComplex()==result.isComplex()
+           && other.getPrecision()==result.getPrecision()
+           && other.getExtents()==result.getExtents())
+          return &other;
+      }
+      return nullptr;
+    }
+
+    /// true if both results differ at most in the planner
+    static bool isPlannerVariant(const ResultBenchmarkT& lhs, const ResultBenchmarkT& rhs) {
+      return lhs.getBatch()==rhs.getBatch()
+        && lhs.getStreams()==rhs.getStreams()
+        && lhs.getNumberDevices()==rhs.getNumberDevices()
+        && lhs.isInplace()==rhs.isInplace()
+        && lhs.isComplex()==rhs.isComplex()
+        && lhs.getPrecision()==rhs.getPrecision()
+        && lhs.getExtents()==rhs.getExtents();
+    }
+
+    /**
+     * Planner sweep (e.g. several FFTW rigors): for benchmarks run with more than
+     * one planner, the plan time (PlanInitFwd+PlanInitInv, runs which paid the setup)
+     * and the execution time (FFT+iFFT) of each planner are written to
+     * <output>_planner.csv and printed. BreakEven is the number of executions
+     * after which a planner pays off against the one planning fastest (reference),
+     * Optimal_From the number of executions from which it has the lowest total time.
+     */
+    void savePlannerTable() const {
+      struct Variant {
+        ResultBenchmarkT* result;
+        double plan;
+        double exec;
+      };
+      std::vector<std::vector<Variant> > groups;
+      std::lock_guard<std::mutex> g(resultAll_->resultsMutex_);
+      for(auto& result : resultAll_->results_) {
+        if(result.hasError())
+          continue;
+        Variant variant = { &result,
+                            meanPlanTime(result),
+                            meanValue(result, RecordType::FFT) + meanValue(result, RecordType::FFTInv) };
+        auto group = std::find_if(groups.begin(), groups.end(), [&](const std::vector<Variant>& vs) {
+            return isPlannerVariant(*vs.front().result, result);
+          });
+        if(group==groups.end())
+          groups.push_back({variant});
+        else
+          group->push_back(variant);
+      }
+      groups.erase(std::remove_if(groups.begin(), groups.end(), [](const std::vector<Variant>& vs) {
+            return vs.size()<2;
+          }), groups.end());
+      if(groups.empty())
+        return;
+
+      std::filesystem::path path(fname_);
+      path.replace_filename(path.stem().string() + "_planner" + path.extension().string());
+      std::ofstream fs(path);
+      fs.precision(PREC);
+      fs << "\"library\",\"inplace\",\"complex\",\"precision\",\"nx\",\"ny\",\"nz\",\"batch\",\"streams\",\"ndevices\""
+         << ",\"planner\",\"Time_Plan [ms]\",\"Time_Execute [ms]\",\"reference\",\"BreakEven [executions]\",\"Optimal_From [executions]\"\n";
+      std::stringstream ss;
+      ss << "\nPlanner break-even (plan: PlanInitFwd+PlanInitInv, execution: FFT+iFFT)\n"
+         << std::setw(40) << "benchmark" << std::setw(20) << "planner"
+         << std::setw(16) << "plan [ms]" << std::setw(16) << "exec [ms]"
+         << std::setw(16) << "break-even" << std::setw(16) << "optimal from" << "\n";
+
+      for(auto& variants : groups) {
+        std::stable_sort(variants.begin(), variants.end(), [](const Variant& lhs, const Variant& rhs) {
+            return lhs.plan<rhs.plan || (lhs.plan==rhs.plan && lhs.exec<rhs.exec);
+          });
+        // lower envelope of plan + n*exec over the number of executions n
+        std::vector<double> optimal(variants.size(), std::numeric_limits<double>::infinity());
+        size_t best = 0;
+        optimal[best] = 0.0;
+        for(;;) {
+          size_t next = variants.size();
+          double from = std::numeric_limits<double>::infinity();
+          for(size_t i=0; i<variants.size(); ++i) {
+            if(variants[i].exec >= variants[best].exec)
+              continue;
+            double n = std::max(optimal[best], breakEven(variants[best].plan, variants[best].exec,
+                                                         variants[i].plan, variants[i].exec));
+            if(n<from || (n==from && variants[i].exec<variants[next].exec)) {
+              next = i;
+              from = n;
+            }
+          }
+          if(next==variants.size())
+            break;
+          optimal[next] = from;
+          best = next;
+        }
+
+        const Variant& reference = variants.front();
+        for(size_t i=0; i<variants.size(); ++i) {
+          const Variant& v = variants[i];
+          const ResultBenchmarkT& result = *v.result;
+          double breakeven = i==0 ? 0.0 : breakEven(reference.plan, reference.exec, v.plan, v.exec);
+          std::string inplace = result.isInplace() ? "Inplace" : "Outplace";
+          std::string complex = result.isComplex() ? "Complex" : "Real";
+          fs << "\"" << apptitle_ << "\"" << SEP
+             << "\"" << inplace << "\"" << SEP
+             << "\"" << complex << "\"" << SEP
+             << "\"" << result.getPrecision() << "\"" << SEP
+             << result.getExtents()[0] << SEP
+             << result.getExtents()[1] << SEP
+             << result.getExtents()[2] << SEP
+             << result.getBatch() << SEP
+             << result.getStreams() << SEP
+             << result.getNumberDevices() << SEP
+             << "\"" << result.getPlanner() << "\"" << SEP
+             << v.plan << SEP
+             << v.exec << SEP
+             << "\"" << reference.result->getPlanner() << "\"" << SEP
+             << breakeven << SEP
+             << optimal[i] << "\n";
+          std::stringstream name;
+          name << result.getPrecision() << "/" << result.getExtents() << "/" << inplace << "_" << complex;
+          ss << std::setw(40) << name.str() << std::setw(20) << result.getPlanner()
+             << std::setw(16) << v.plan << std::setw(16) << v.exec
+             << std::setw(16) << breakeven << std::setw(16) << optimal[i] << "\n";
+        }
+      }
+      OUT << ss.str() << "\nPlanner table written to " << path.string() << std::endl;
+    }
+
+    /// average plan time of the runs which paid the setup (measured runs if any)
+    static double meanPlanTime(ResultBenchmarkT& result) {
+      double sum = 0.0;
+      int count = 0;
+      for(int first : {result.getNumberWarmups(), 0}) {
+        for(int run=first; run<result.getNumberRuns(); ++run) {
+          result.setRun(run);
+          if(result.getValue(RecordType::SetupPaid)==0.0)
+            continue;
+          sum += result.getValue(RecordType::PlanInitFwd) + result.getValue(RecordType::PlanInitInv);
+          ++count;
+        }
+        if(count>0)
+          break;
+      }
+      return count>0 ? sum/count : 0.0;
+    }
+
+    /// average of a record over the measured runs
+    static double meanValue(ResultBenchmarkT& result, RecordType record) {
+      double sum = 0.0;
+      for(int run=result.getNumberWarmups(); run<result.getNumberRuns(); ++run) {
+        result.setRun(run);
+        sum += result.getValue(record);
+      }
+      return sum/std::max(1, result.getNumberWarmRuns());
+    }
+
+    /**
+     * Nominal GFLOP/s of FFT and iFFT and effective bandwidths.
+     * A transform reads and writes its buffers once (inplace buffers twice),
+     * upload and download move Size_DeviceTransfer bytes.
+     * \param value returns value of given record type (ms, bytes)
+     */
+    template<typename T_Value>
+    static DerivedT derivedValues(const ResultBenchmarkT& result, T_Value value) {
+      auto per_ms = [](double amount, double ms) {
+        return ms > 0.0 ? amount / (ms * 1.0e6) : 0.0;
+      };
+      double flops = result.getNominalFlops();
+      double buffer = value(RecordType::DevBufferSize);
+      double transfer = value(RecordType::DevTransferSize);
+      if(result.isInplace())
+        buffer *= 2.0;
+      return DerivedT{ {
+          per_ms(flops, value(RecordType::FFT)),
+          per_ms(flops, value(RecordType::FFTInv)),
+          per_ms(buffer, value(RecordType::FFT)),
+          per_ms(buffer, value(RecordType::FFTInv)),
+          per_ms(transfer, value(RecordType::Upload)),
+          per_ms(transfer, value(RecordType::Download))
+        } };
     }
 
     void footerOut() const {
@@ -227,9 +480,12 @@ namespace gearshifft {
       }
       // header
       stream << "\"library\",\"inplace\",\"complex\",\"precision\",\"dim\",\"kind\""
-             << ",\"nx\",\"ny\",\"nz\",\"run\",\"id\",\"success\"";
-      for(auto ival=0; ival<T_NumberValues; ++ival) {
-        stream << SEP << '"' << static_cast<RecordType>(ival) << '"';
+             << ",\"nx\",\"ny\",\"nz\",\"batch\",\"streams\",\"ndevices\",\"planner\",\"runs\",\"run\",\"id\",\"success\"";
+      for(auto record : records_) {
+        stream << SEP << '"' << record << '"';
+      }
+      for(auto title : DERIVED_TITLES) {
+        stream << SEP << '"' << title << '"';
       }
       stream << "\n";
     }
@@ -239,7 +495,7 @@ namespace gearshifft {
       std::string inplace = result.isInplace() ? "Inplace" : "Outplace";
       std::string complex = result.isComplex() ? "Complex" : "Real";
 
-      for(auto run=0; run<T_NumberRuns; ++run) {
+      for(auto run=0; run<result.getNumberRuns(); ++run) {
         result.setRun(run);
         stream << "\"" << apptitle_ << "\"" << SEP
                << "\"" << inplace   << "\"" << SEP
@@ -250,6 +506,11 @@ namespace gearshifft {
                << result.getExtents()[0] << SEP
                << result.getExtents()[1] << SEP
                << result.getExtents()[2] << SEP
+               << result.getBatch() << SEP
+               << result.getStreams() << SEP
+               << result.getNumberDevices() << SEP
+               << "\"" << result.getPlanner() << "\"" << SEP
+               << result.getNumberWarmRuns() << SEP
                << run << SEP
                << result.getID();
         // was run successfull?
@@ -259,15 +520,21 @@ namespace gearshifft {
           else
             stream << SEP << "\"Skipped\""; // subsequent runs did not run
         } else {
-          if(run<T_NumberWarmups)
+          if(run<result.getNumberWarmups())
             stream << SEP << "\"" << "Warmup" << "\"";
           else
             stream << SEP << "\"" << "Success" << "\"";
         }
 
         // measured time and size values
-        for(auto ival=0; ival<T_NumberValues; ++ival) {
-          stream << SEP << result.getValue(ival);
+        for(auto record : records_) {
+          stream << SEP << result.getValue(record);
+        }
+        DerivedT derived = derivedValues(result, [&](RecordType r) {
+            return result.getValue(r);
+          });
+        for(auto value : derived) {
+          stream << SEP << value;
         }
 
         stream << "\n";
@@ -281,8 +548,11 @@ namespace gearshifft {
 
   };
 
-  template<int T_NumberRuns, int T_NumberWarmups, int T_NumberValues>
-  constexpr char ResultWriter<T_NumberRuns, T_NumberWarmups, T_NumberValues>::BAK_SUFFIX[];
+  template<int T_NumberValues>
+  constexpr char ResultWriter<T_NumberValues>::BAK_SUFFIX[];
+
+  template<int T_NumberValues>
+  constexpr const char* ResultWriter<T_NumberValues>::DERIVED_TITLES[];
 }
 
 #endif
@@ -0,0 +1,158 @@
+#ifndef STATISTICS_HPP_
+#define STATISTICS_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+namespace gearshifft {
+
+  /// two-sided 95% quantile of Student's t-distribution with df degrees of freedom
+  inline double studentT95(size_t df) {
+    static constexpr double table[] = {
+      12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+      2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+      2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+    static constexpr size_t tsize = sizeof(table)/sizeof(table[0]);
+    if(df==0)
+      return std::numeric_limits<double>::infinity();
+    if(df<=tsize)
+      return table[df-1];
+    // Cornish-Fisher expansion around the normal quantile
+    const double z = 1.959964;
+    const double v = static_cast<double>(df);
+    return z + (z*z*z+z)/(4.0*v) + (5.0*z*z*z*z*z+16.0*z*z*z+3.0*z)/(96.0*v*v);
+  }
+
+  /**
+   * Running mean and variance (Welford) of the samples added so far.
+   * Used for the confidence interval of the adaptive benchmark repetition.
+   */
+  class RunningStats {
+  public:
+
+    void add(double x) {
+      ++n_;
+      double delta = x - mean_;
+      mean_ += delta / static_cast<double>(n_);
+      m2_ += delta * (x - mean_);
+    }
+
+    void clear() {
+      n_ = 0;
+      mean_ = 0.0;
+      m2_ = 0.0;
+    }
+
+    size_t count() const { return n_; }
+    double mean() const { return mean_; }
+
+    /// sample variance
+    double variance() const {
+      return n_>1 ? m2_/static_cast<double>(n_-1) : 0.0;
+    }
+
+    /// half-width of the 95% confidence interval of the mean relative to the mean
+    double relativeCI() const {
+      if(n_<2 || mean_==0.0)
+        return std::numeric_limits<double>::infinity();
+      double hw = studentT95(n_-1) * std::sqrt(variance()/static_cast<double>(n_));
+      return std::fabs(hw/mean_);
+    }
+
+  private:
+    size_t n_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;
+  };
+
+  /**
+   * Decides when an adaptive benchmark stops repeating its runs.
+   *
+   * Warmup is over as soon as the sum of FFT and iFFT time of two
+   * consecutive runs differs by less than WARMUP_TOLERANCE (at most half
+   * of the maximum number of runs are warmups).
+   * Afterwards runs are repeated until the relative 95% confidence intervals
+   * of both FFT and iFFT times are below the target, or until the maximum
+   * number of runs or the time limit is reached.
+   */
+  class AdaptiveRepetition {
+  public:
+    static constexpr double WARMUP_TOLERANCE = 0.1;
+    /// minimum number of runs after warmup
+    static constexpr size_t MIN_RUNS = 3;
+
+    AdaptiveRepetition(double targetCI, int maxRuns, double maxTime)
+      : targetCI_(targetCI), maxRuns_(maxRuns), maxTime_(maxTime),
+        start_(std::chrono::steady_clock::now()) {}
+
+    /**
+     * Adds the times of the run just completed.
+     * @return true if another run is required
+     */
+    bool next(double timeFFT, double timeIFFT) {
+      ++runs_;
+      const double t = timeFFT + timeIFFT;
+      if(warmup_) {
+        ++warmups_;
+        if( runs_>1 && std::fabs(t-last_) <= WARMUP_TOLERANCE*last_ )
+          warmup_ = false;
+        else if( warmups_ >= maxRuns_/2 )
+          warmup_ = false;
+        last_ = t;
+      } else {
+        fft_.add(timeFFT);
+        ifft_.add(timeIFFT);
+        if( fft_.count()>=MIN_RUNS
+            && fft_.relativeCI()<=targetCI_
+            && ifft_.relativeCI()<=targetCI_ )
+          return false;
+      }
+      if( runs_>=maxRuns_ || timeout() ) {
+        if(warmups_==runs_) // keep the last run as measurement
+          --warmups_;
+        return false;
+      }
+      return true;
+    }
+
+    int getNumberRuns() const { return runs_; }
+    int getNumberWarmups() const { return warmups_; }
+
+  private:
+    double targetCI_;
+    int maxRuns_;
+    double maxTime_;
+    std::chrono::steady_clock::time_point start_;
+    bool warmup_ = true;
+    int runs_ = 0;
+    int warmups_ = 0;
+    double last_ = 0.0;
+    RunningStats fft_;
+    RunningStats ifft_;
+
+    bool timeout() const {
+      if(maxTime_<=0.0)
+        return false;
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_;
+      return elapsed.count() >= maxTime_;
+    }
+  };
+
+  /**
+   * Number of executions after which a planner b pays off against planner a,
+   * i.e. from which plan_b + n*exec_b <= plan_a + n*exec_a (0 if b is not more
+   * expensive to plan, infinity if b does not execute faster).
+   */
+  inline double breakEven(double plan_a, double exec_a, double plan_b, double exec_b) {
+    if(exec_b >= exec_a)
+      return plan_b <= plan_a && exec_b == exec_a ? 0.0 : std::numeric_limits<double>::infinity();
+    return std::max(0.0, (plan_b - plan_a) / (exec_a - exec_b));
+  }
+
+} // gearshifft
+
+#endif
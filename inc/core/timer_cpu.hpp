@@ -1,26 +1,34 @@
-
 #ifndef TIMER_CPU_HPP_
 #define TIMER_CPU_HPP_
 
 #include "timer.hpp"
+#include "timer_tsc.hpp"
 #include <chrono>
 #include <stdexcept>
 
 namespace gearshifft {
 
   /** CPU Wall timer
+   * Uses the time stamp counter if selected by --timer tsc (see TSC),
+   * std::chrono::high_resolution_clock otherwise.
    */
   struct TimerCPU_ {
     typedef std::chrono::high_resolution_clock clock;
 
-    clock::time_point start;
+    clock::time_point start; // chrono clock
+    uint64_t start_tsc = 0; // --timer tsc
     double time = 0.0;
 
     void startTimer() {
-      start = clock::now();
+      if(TSC::isEnabled())
+        start_tsc = TSC::start();
+      else
+        start = clock::now();
     }
 
     double stopTimer() {
+      if(TSC::isEnabled())
+        return (time = TSC::elapsed(start_tsc, TSC::stop()));
       auto diff = clock::now() - start;
       return (time = std::chrono::duration<double, std::milli> (diff).count());
     }
@@ -0,0 +1,169 @@
+#ifndef TIMER_TSC_HPP_
+#define TIMER_TSC_HPP_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define GEARSHIFFT_HAS_TSC 1
+#endif
+
+namespace gearshifft {
+
+  /**
+   * Time stamp counter of x86 CPUs (--timer tsc).
+   *
+   * Reads are fenced (lfence; rdtsc; lfence at start, rdtscp; lfence at stop),
+   * so the timed instructions neither move before the start nor after the stop.
+   * calibrate() measures the TSC frequency against std::chrono::steady_clock
+   * and the overhead of an empty start/stop pair, which is subtracted from
+   * all measurements.  Requires an invariant TSC (constant rate in all P-states).
+   * There is no separate TSC timer, TimerCPU reads the TSC when it is enabled.
+   */
+  class TSC {
+  public:
+
+    static bool isSupported() {
+#ifdef GEARSHIFFT_HAS_TSC
+      unsigned a = 0, b = 0, c = 0, d = 0;
+      if(!__get_cpuid(0x80000007, &a, &b, &c, &d))
+        return false;
+      return (d & (1u << 8)) != 0; // invariant TSC
+#else
+      return false;
+#endif
+    }
+
+    /**
+     * Selects the TSC for TimerCPU and calibrates it (called at context creation).
+     * Falls back to the chrono clock if the TSC is not supported.
+     */
+    static void configure(bool enable) {
+      state().enabled = false;
+      state().unsupported = false;
+      if(!enable)
+        return;
+      if(!isSupported()) {
+        std::cerr << "gearshifft: no invariant TSC available, timer falls back to chrono.\n";
+        state().unsupported = true;
+        return;
+      }
+      calibrate();
+      state().enabled = true;
+    }
+
+    static bool isEnabled() {
+      return state().enabled;
+    }
+
+    static uint64_t start() {
+#ifdef GEARSHIFFT_HAS_TSC
+      _mm_lfence();
+      uint64_t t = __rdtsc();
+      _mm_lfence();
+      return t;
+#else
+      return 0;
+#endif
+    }
+
+    static uint64_t stop() {
+#ifdef GEARSHIFFT_HAS_TSC
+      unsigned aux = 0;
+      uint64_t t = __rdtscp(&aux);
+      _mm_lfence();
+      return t;
+#else
+      return 0;
+#endif
+    }
+
+    /// elapsed time in ms without the timer overhead
+    static double elapsed(uint64_t begin, uint64_t end) {
+      uint64_t ticks = end - begin;
+      ticks = ticks > state().overhead ? ticks - state().overhead : 0;
+      return static_cast<double>(ticks) * state().msPerTick;
+    }
+
+    static double frequency() {
+      return 1.0e3 / state().msPerTick;
+    }
+
+    /// csv meta information on the timer used by TimerCPU
+    static std::string properties() {
+      std::ostringstream msg;
+      if(isEnabled()) {
+        msg << ",\"Timer\",\"tsc\""
+            << ",\"TimerResolution [ns]\"," << 1.0e6 * state().msPerTick
+            << ",\"TimerOverhead [ns]\"," << 1.0e6 * state().msPerTick * static_cast<double>(state().overhead)
+            << ",\"TSCFrequency [Hz]\"," << static_cast<uint64_t>(frequency());
+      } else {
+        msg << ",\"Timer\",\"chrono" << (state().unsupported ? " (tsc not supported)" : "") << "\""
+            << ",\"TimerResolution [ns]\"," << chronoResolution();
+      }
+      return msg.str();
+    }
+
+  private:
+    struct State {
+      bool enabled = false;
+      bool unsupported = false;
+      double msPerTick = 0.0;
+      uint64_t overhead = 0;
+    };
+
+    static State& state() {
+      static State s;
+      return s;
+    }
+
+    /// median of three 20 ms rounds against the steady clock, then the minimum of empty start/stop pairs
+    static void calibrate() {
+      using clock = std::chrono::steady_clock;
+      std::vector<double> rates;
+      for(int round = 0; round < 3; ++round) {
+        auto t0 = clock::now();
+        uint64_t c0 = start();
+        clock::time_point t1;
+        do {
+          t1 = clock::now();
+        } while(t1 - t0 < std::chrono::milliseconds(20));
+        uint64_t c1 = stop();
+        double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+        rates.push_back(ms / static_cast<double>(c1 - c0));
+      }
+      std::sort(rates.begin(), rates.end());
+      state().msPerTick = rates[1];
+
+      uint64_t overhead = UINT64_MAX;
+      for(int i = 0; i < 1000; ++i) {
+        uint64_t begin = start();
+        uint64_t end = stop();
+        overhead = std::min(overhead, end - begin);
+      }
+      state().overhead = overhead;
+    }
+
+    /// smallest non-zero step of the chrono clock [ns]
+    static double chronoResolution() {
+      using clock = std::chrono::high_resolution_clock;
+      double resolution = 1.0e9;
+      for(int i = 0; i < 100; ++i) {
+        auto t0 = clock::now();
+        auto t1 = clock::now();
+        while(t1 == t0)
+          t1 = clock::now();
+        resolution = std::min(resolution, std::chrono::duration<double, std::nano>(t1 - t0).count());
+      }
+      return resolution;
+    }
+  };
+}
+#endif /* TIMER_TSC_HPP_ */
@@ -16,6 +16,8 @@
 #include <complex>
 #include <iostream>
 #include <limits>
+#include <string>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -99,6 +101,24 @@ namespace gearshifft {
 # endif
 #endif
 
+  /// parameters of a benchmark besides FFT kind, precision and extents
+  struct BenchmarkConfig {
+    /// number of transforms per plan
+    size_t batch = 1;
+    /// number of concurrent FFT streams
+    size_t streams = 1;
+    /// number of devices (CPU threads), 0=all
+    size_t ndevices = 0;
+    /// planner variant, e.g. FFTW rigor and timelimit (empty if the library has none)
+    std::string planner;
+  };
+
+  inline
+  bool operator<(const BenchmarkConfig& lhs, const BenchmarkConfig& rhs) {
+    return std::tie(lhs.batch, lhs.streams, lhs.ndevices, lhs.planner)
+      < std::tie(rhs.batch, rhs.streams, rhs.ndevices, rhs.planner);
+  }
+
   enum struct RecordType {
     Allocation = 0,
     PlanInitFwd,
@@ -114,9 +134,119 @@ namespace gearshifft {
     DevTransferSize,
     Deviation,
     Mismatches,
+    SetupPaid,
+    StreamsTime,
+    StreamsThroughput,
+    StreamsSlowestFFT,
+    StreamsSlowestFFTInv,
+    LatencyFFTP50,
+    LatencyFFTP90,
+    LatencyFFTP99,
+    LatencyFFTP999,
+    LatencyFFTMax,
+    LatencyFFTInvP50,
+    LatencyFFTInvP90,
+    LatencyFFTInvP99,
+    LatencyFFTInvP999,
+    LatencyFFTInvMax,
+    PerfUploadCycles, ///< first of the hardware counter records, see PerfCounters
+    PerfUploadInstructions,
+    PerfUploadLLCMisses,
+    PerfUploadDTLBMisses,
+    PerfUploadBranchMisses,
+    PerfFFTCycles,
+    PerfFFTInstructions,
+    PerfFFTLLCMisses,
+    PerfFFTDTLBMisses,
+    PerfFFTBranchMisses,
+    PerfFFTInvCycles,
+    PerfFFTInvInstructions,
+    PerfFFTInvLLCMisses,
+    PerfFFTInvDTLBMisses,
+    PerfFFTInvBranchMisses,
+    PerfDownloadCycles,
+    PerfDownloadInstructions,
+    PerfDownloadLLCMisses,
+    PerfDownloadDTLBMisses,
+    PerfDownloadBranchMisses,
+    PageSizeDevice,
+    PageSizeHost,
+    FlushTime,
+    RingBuffers,
+    InnerRepetitionsFFT,
+    InnerRepetitionsFFTInv,
+    Validated,
+    MemoryAllocation, ///< first of the resident set size records, see MemoryUsage
+    MemoryPlanInitFwd,
+    MemoryPlanInitInv,
+    MemoryExecute,
+    MemoryPlanDestroy,
+    MemoryPeak,
+    NoiseVoluntarySwitches, ///< first of the operating system noise records, see OsNoise
+    NoiseInvoluntarySwitches,
+    NoiseMigrations,
+    NoiseMinorFaults,
+    NoiseMajorFaults,
+    NoiseInterrupts,
+    NoiseFlagged,
+    AllocPlanBytes, ///< first of the heap allocation records, see AllocTracker
+    AllocPlanCount,
+    AllocExecuteBytes,
+    AllocExecuteCount,
+    AllocDestroyBytes,
+    WisdomExport,
     NrRecords_
   };
 
+  /// optional records are only written if enabled by program options
+  enum struct RecordGroup {
+    Default,
+    SteadyState,
+    Streams,
+    Latency,
+    PerfCounters,
+    HugePages,
+    Flush,
+    BufferRing,
+    InnerRepetition,
+    Validation,
+    Memory,
+    OsNoise,
+    Allocations,
+    WisdomCache
+  };
+
+  inline
+  RecordGroup recordGroup(RecordType r) {
+    if(r == RecordType::WisdomExport)
+      return RecordGroup::WisdomCache;
+    if(r >= RecordType::AllocPlanBytes && r <= RecordType::AllocDestroyBytes)
+      return RecordGroup::Allocations;
+    if(r >= RecordType::NoiseVoluntarySwitches && r <= RecordType::NoiseFlagged)
+      return RecordGroup::OsNoise;
+    if(r >= RecordType::MemoryAllocation && r <= RecordType::MemoryPeak)
+      return RecordGroup::Memory;
+    if(r == RecordType::Validated)
+      return RecordGroup::Validation;
+    if(r == RecordType::InnerRepetitionsFFT || r == RecordType::InnerRepetitionsFFTInv)
+      return RecordGroup::InnerRepetition;
+    if(r == RecordType::RingBuffers)
+      return RecordGroup::BufferRing;
+    if(r == RecordType::FlushTime)
+      return RecordGroup::Flush;
+    if(r == RecordType::PageSizeDevice || r == RecordType::PageSizeHost)
+      return RecordGroup::HugePages;
+    if(r >= RecordType::PerfUploadCycles && r <= RecordType::PerfDownloadBranchMisses)
+      return RecordGroup::PerfCounters;
+    if(r >= RecordType::LatencyFFTP50 && r <= RecordType::LatencyFFTInvMax)
+      return RecordGroup::Latency;
+    if(r >= RecordType::StreamsTime && r <= RecordType::StreamsSlowestFFTInv)
+      return RecordGroup::Streams;
+    if(r == RecordType::SetupPaid)
+      return RecordGroup::SteadyState;
+    return RecordGroup::Default;
+  }
+
   inline
   std::ostream& operator<< (std::ostream & os, RecordType r) {
     switch (r) {
@@ -134,6 +264,67 @@ namespace gearshifft {
     case RecordType::DevTransferSize: return os << "Size_DeviceTransfer [bytes]";
     case RecordType::Deviation: return os << "Error_StandardDeviation";
     case RecordType::Mismatches: return os << "Error_Mismatches";
+    case RecordType::SetupPaid: return os << "Setup_Paid";
+    case RecordType::StreamsTime: return os << "Time_Streams [ms]";
+    case RecordType::StreamsThroughput: return os << "Streams_Throughput [transforms/s]";
+    case RecordType::StreamsSlowestFFT: return os << "Time_FFT_Slowest [ms]";
+    case RecordType::StreamsSlowestFFTInv: return os << "Time_iFFT_Slowest [ms]";
+    case RecordType::LatencyFFTP50: return os << "Latency_FFT_p50 [ms]";
+    case RecordType::LatencyFFTP90: return os << "Latency_FFT_p90 [ms]";
+    case RecordType::LatencyFFTP99: return os << "Latency_FFT_p99 [ms]";
+    case RecordType::LatencyFFTP999: return os << "Latency_FFT_p99.9 [ms]";
+    case RecordType::LatencyFFTMax: return os << "Latency_FFT_max [ms]";
+    case RecordType::LatencyFFTInvP50: return os << "Latency_iFFT_p50 [ms]";
+    case RecordType::LatencyFFTInvP90: return os << "Latency_iFFT_p90 [ms]";
+    case RecordType::LatencyFFTInvP99: return os << "Latency_iFFT_p99 [ms]";
+    case RecordType::LatencyFFTInvP999: return os << "Latency_iFFT_p99.9 [ms]";
+    case RecordType::LatencyFFTInvMax: return os << "Latency_iFFT_max [ms]";
+    case RecordType::PerfUploadCycles: return os << "Perf_Upload_Cycles";
+    case RecordType::PerfUploadInstructions: return os << "Perf_Upload_Instructions";
+    case RecordType::PerfUploadLLCMisses: return os << "Perf_Upload_LLCMisses";
+    case RecordType::PerfUploadDTLBMisses: return os << "Perf_Upload_dTLBMisses";
+    case RecordType::PerfUploadBranchMisses: return os << "Perf_Upload_BranchMisses";
+    case RecordType::PerfFFTCycles: return os << "Perf_FFT_Cycles";
+    case RecordType::PerfFFTInstructions: return os << "Perf_FFT_Instructions";
+    case RecordType::PerfFFTLLCMisses: return os << "Perf_FFT_LLCMisses";
+    case RecordType::PerfFFTDTLBMisses: return os << "Perf_FFT_dTLBMisses";
+    case RecordType::PerfFFTBranchMisses: return os << "Perf_FFT_BranchMisses";
+    case RecordType::PerfFFTInvCycles: return os << "Perf_iFFT_Cycles";
+    case RecordType::PerfFFTInvInstructions: return os << "Perf_iFFT_Instructions";
+    case RecordType::PerfFFTInvLLCMisses: return os << "Perf_iFFT_LLCMisses";
+    case RecordType::PerfFFTInvDTLBMisses: return os << "Perf_iFFT_dTLBMisses";
+    case RecordType::PerfFFTInvBranchMisses: return os << "Perf_iFFT_BranchMisses";
+    case RecordType::PerfDownloadCycles: return os << "Perf_Download_Cycles";
+    case RecordType::PerfDownloadInstructions: return os << "Perf_Download_Instructions";
+    case RecordType::PerfDownloadLLCMisses: return os << "Perf_Download_LLCMisses";
+    case RecordType::PerfDownloadDTLBMisses: return os << "Perf_Download_dTLBMisses";
+    case RecordType::PerfDownloadBranchMisses: return os << "Perf_Download_BranchMisses";
+    case RecordType::PageSizeDevice: return os << "Size_PageDevice [bytes]";
+    case RecordType::PageSizeHost: return os << "Size_PageHost [bytes]";
+    case RecordType::FlushTime: return os << "Time_Flush [ms]";
+    case RecordType::RingBuffers: return os << "Buffers_Ring";
+    case RecordType::InnerRepetitionsFFT: return os << "Repetitions_FFT";
+    case RecordType::InnerRepetitionsFFTInv: return os << "Repetitions_iFFT";
+    case RecordType::Validated: return os << "Validated";
+    case RecordType::MemoryAllocation: return os << "Memory_Allocation [bytes]";
+    case RecordType::MemoryPlanInitFwd: return os << "Memory_PlanInitFwd [bytes]";
+    case RecordType::MemoryPlanInitInv: return os << "Memory_PlanInitInv [bytes]";
+    case RecordType::MemoryExecute: return os << "Memory_Execute [bytes]";
+    case RecordType::MemoryPlanDestroy: return os << "Memory_PlanDestroy [bytes]";
+    case RecordType::MemoryPeak: return os << "Memory_Peak [bytes]";
+    case RecordType::NoiseVoluntarySwitches: return os << "Noise_VoluntarySwitches";
+    case RecordType::NoiseInvoluntarySwitches: return os << "Noise_InvoluntarySwitches";
+    case RecordType::NoiseMigrations: return os << "Noise_Migrations";
+    case RecordType::NoiseMinorFaults: return os << "Noise_MinorFaults";
+    case RecordType::NoiseMajorFaults: return os << "Noise_MajorFaults";
+    case RecordType::NoiseInterrupts: return os << "Noise_Interrupts";
+    case RecordType::NoiseFlagged: return os << "Noise_Flagged";
+    case RecordType::AllocPlanBytes: return os << "Alloc_Plan [bytes]";
+    case RecordType::AllocPlanCount: return os << "Alloc_Plan [count]";
+    case RecordType::AllocExecuteBytes: return os << "Alloc_Execute [bytes]";
+    case RecordType::AllocExecuteCount: return os << "Alloc_Execute [count]";
+    case RecordType::AllocDestroyBytes: return os << "Alloc_Destroy [bytes]";
+    case RecordType::WisdomExport: return os << "Time_WisdomExport [ms]";
     case RecordType::NrRecords_:
     default:
       ;
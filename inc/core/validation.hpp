@@ -0,0 +1,120 @@
+#ifndef VALIDATION_HPP_
+#define VALIDATION_HPP_
+
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+namespace gearshifft {
+
+  /**
+   * Validation policy of the round trip results (--validate).
+   *
+   * - every: all elements of every run (default)
+   * - first, last: all elements of the first or last run only
+   * - sample:N: all elements of every N-th run (first run included)
+   * - stride:K: every K-th element of every run
+   *
+   * Runs and elements not compared are still probed for NaN and Inf,
+   * see BenchmarkData::count_nonfinite().
+   * In adaptive mode (--target-ci) the last run is not known in advance,
+   * `last` validates every run then.
+   */
+  class Validation {
+  public:
+    enum class Kind { Every, First, Last, Sample, Stride };
+
+    static bool isValid(const std::string& spec) {
+      Kind kind;
+      size_t n;
+      return parse(spec, kind, n);
+    }
+
+    static void configure(const std::string& spec, bool adaptive) {
+      spec_() = spec;
+      parse(spec, kind_(), n_());
+      adaptive_() = adaptive;
+    }
+
+    static bool isEvery() {
+      return kind_() == Kind::Every;
+    }
+
+    /// true if the elements of run r (of nruns) are compared
+    static bool selects(int r, int nruns) {
+      switch(kind_()) {
+      case Kind::First: return r == 0;
+      case Kind::Last: return adaptive_() || r == nruns-1;
+      case Kind::Sample: return static_cast<size_t>(r) % n_() == 0;
+      case Kind::Every:
+      case Kind::Stride: break;
+      }
+      return true;
+    }
+
+    /// distance of the compared elements
+    static size_t stride() {
+      return kind_() == Kind::Stride ? n_() : 1;
+    }
+
+    /// csv meta information
+    static std::string properties() {
+      std::ostringstream msg;
+      msg << ",\"Validate\",\"" << spec_() << "\"";
+      return msg.str();
+    }
+
+  private:
+    static std::string& spec_() {
+      static std::string spec = "every";
+      return spec;
+    }
+
+    static Kind& kind_() {
+      static Kind kind = Kind::Every;
+      return kind;
+    }
+
+    static size_t& n_() {
+      static size_t n = 1;
+      return n;
+    }
+
+    static bool& adaptive_() {
+      static bool adaptive = false;
+      return adaptive;
+    }
+
+    static bool parse(const std::string& spec, Kind& kind, size_t& n) {
+      n = 1;
+      if(spec == "every")
+        kind = Kind::Every;
+      else if(spec == "first")
+        kind = Kind::First;
+      else if(spec == "last")
+        kind = Kind::Last;
+      else {
+        auto colon = spec.find(':');
+        if(colon == std::string::npos)
+          return false;
+        std::string name = spec.substr(0, colon);
+        std::string value = spec.substr(colon+1);
+        if(name == "sample")
+          kind = Kind::Sample;
+        else if(name == "stride")
+          kind = Kind::Stride;
+        else
+          return false;
+        if(value.empty() || value.find_first_not_of("0123456789") != std::string::npos)
+          return false;
+        n = std::stoul(value);
+        if(n == 0)
+          return false;
+      }
+      return true;
+    }
+  };
+
+} // gearshifft
+
+#endif /* VALIDATION_HPP_ */
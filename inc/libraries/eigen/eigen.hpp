@@ -8,6 +8,8 @@
 #include "core/timer.hpp"
 #include "core/fft.hpp"
 #include "core/benchmark_suite.hpp"
+#include "core/buffer_ring.hpp"
+#include "core/cpu_placement.hpp"
 #include "core/get_memory_size.hpp"
 #include "core/unused.hpp"
 
@@ -19,10 +21,6 @@
 #include <type_traits>
 #include <vector>
 
-#define EIGEN_RUNTIME_NO_MALLOC                 // ensure that the allocate() allocates all memory and there
-                                                // is no dynamic allocation during other stages
-                                                // todo: remove once certain that no assertions are broken
-                                                //       as it adds overhead in measurements
 #include <Eigen/Core>
 #include <unsupported/Eigen/FFT>
 
@@ -180,6 +178,8 @@ namespace gearshifft
 
       /// product of corresponding extents
       size_t n_ = 0;
+      /// number of transforms, stored consecutively in data_ and data_complex_
+      size_t batch_ = 1;
 
       data_type* data_ = nullptr;     
       data_complex_type* data_complex_ = nullptr;
@@ -189,16 +189,23 @@ namespace gearshifft
       /// size in nr of elements(!) of FFT(input) for out-of-place transforms
       size_t data_complex_size_ = 0;
 
+      /// buffer pairs of --buffer-ring, data_ and data_complex_ point to the pair of the next execution
+      std::vector<data_type*> ring_data_;
+      std::vector<data_complex_type*> ring_complex_;
+      BufferRing ring_;
+
       fft_wrapper_type eigen_fft_;
       int eigen_fft_flags_ = EigenContext::options().flags();
 
-      EigenImpl(const Extent &cextents)
+      EigenImpl(const Extent &cextents, size_t batch = 1) : batch_(batch)
       {
         #ifdef EIGEN_MKL_DEFAULT
         // NOTE: according to doc, the number serves as a hint and MKL may opt to use less!
         mkl_set_num_threads(EigenContext::options().getNumberDevices());
+        CpuPlacement::get().apply(EigenContext::options().getNumberDevices());
+        #else
+        CpuPlacement::get().apply(1);
         #endif
-        Eigen::internal::set_is_malloc_allowed(false); // disable eigen internal malloc
         
         extents_ = interpret_as::column_major(cextents);
 
@@ -208,14 +215,18 @@ namespace gearshifft
                              1,
                              std::multiplies<std::size_t>());
 
-        data_size_ = n_;
+        data_size_ = n_ * batch_;
         data_complex_size_ = data_size_;
 
+        if(BufferRing::isEnabled())
+          ring_ = BufferRing(BufferRing::count(get_allocation_size()));
+        const size_t ring_size = (ring_.size() - 1) * get_allocation_size();
+
         size_t total_mem = 95 * getMemorySize() / 100; // keep some memory available, otherwise an out-of-memory killer becomes more likely
-        if (total_mem < 3 * data_size_ * sizeof(value_type) + data_complex_size_ * sizeof(ComplexType))
+        if (total_mem < 3 * data_size_ * sizeof(value_type) + data_complex_size_ * sizeof(ComplexType) + ring_size)
         { // includes host input buffers
           std::stringstream ss;
-          ss << total_mem << "<" << 3 * data_size_ * sizeof(value_type) + data_complex_size_ * sizeof(ComplexType) << " (bytes)";
+          ss << total_mem << "<" << 3 * data_size_ * sizeof(value_type) + data_complex_size_ * sizeof(ComplexType) + ring_size << " (bytes)";
           throw std::runtime_error("FFT data exceeds physical memory. " + ss.str());
         }
       }
@@ -227,19 +238,41 @@ namespace gearshifft
 
       void allocate()
       {
-        Eigen::internal::set_is_malloc_allowed(true); // enable eigen internal malloc
-        data_ = new data_type(data_size_);
-        data_complex_ = new data_complex_type(data_complex_size_);
+        ring_ = BufferRing(ring_.size());
+        for(size_t i = 0; i < ring_.size(); ++i) {
+          ring_data_.push_back(new data_type(data_size_));
+          ring_complex_.push_back(new data_complex_type(data_complex_size_));
+          CpuPlacement::get().bind(ring_data_.back()->data(), data_size_ * sizeof(value_type));
+          CpuPlacement::get().bind(ring_complex_.back()->data(), data_complex_size_ * sizeof(ComplexType));
+        }
+        select(ring_.current());
+      }
+
+      /**
+       * Fills all buffer pairs of the ring with the input (--buffer-ring, not timed),
+       * returns the number of pairs.
+       */
+      template <typename THostData>
+      size_t prime(THostData *input)
+      {
+        if(!ring_.isPrimed()) {
+          for(size_t i = 0; i < ring_.size(); ++i)
+            std::memcpy(ring_data_[ring_.fillOrder(i)]->data(), input, data_size_ * sizeof(value_type));
+          ring_.setPrimed(true);
+        }
+        return ring_.size();
       }
 
       void destroy()
       {
-        if(data_)
-          delete data_;
+        for(auto data : ring_data_)
+          delete data;
+        ring_data_.clear();
         data_ = nullptr;
 
-        if(data_complex_)
-          delete data_complex_;
+        for(auto data : ring_complex_)
+          delete data;
+        ring_complex_.clear();
         data_complex_ = nullptr;
       }
 
@@ -273,7 +306,6 @@ namespace gearshifft
       // todo: maybe with eigen_fft_.impl() you can get to it...
       void init_forward()
       {
-        Eigen::internal::set_is_malloc_allowed(true); // enable eigen internal malloc
         // re-call constructor
         eigen_fft_ = fft_wrapper_type(Eigen::default_fft_impl<TPrecision>(),
                                       eigen_fft_flags_);
@@ -282,20 +314,25 @@ namespace gearshifft
       }
       void init_inverse()
       {
-        Eigen::internal::set_is_malloc_allowed(true); // enable eigen internal malloc
         // Plan creation will happen in warmup rounds hopefully
       }
 
+      // Transforms of a batch are executed one after another on the batched buffer.
+      // The pointer API is used, so the half spectrum does not resize data_complex_.
       void execute_forward()
       {
-        Eigen::internal::set_is_malloc_allowed(true); // disable eigen internal malloc
-        eigen_fft_.fwd(*data_complex_, *data_);
+        for(size_t b = 0; b < batch_; ++b)
+          eigen_fft_.fwd(data_complex_->data() + b * n_, data_->data() + b * n_, n_);
       }
 
       void execute_inverse()
       {
-        Eigen::internal::set_is_malloc_allowed(true); // disable eigen internal malloc
-        eigen_fft_.inv(*data_, *data_complex_);
+        for(size_t b = 0; b < batch_; ++b)
+          eigen_fft_.inv(data_->data() + b * n_, data_complex_->data() + b * n_, n_);
+        if(ring_.size() > 1) {
+          ring_.advance();
+          select(ring_.current());
+        }
       }
 
       // todo: how does reuseplan work? fft.hpp just seems to call init_inverse at
@@ -307,7 +344,7 @@ namespace gearshifft
       {
         static_assert(std::is_same<THostData,value_type>::value
                       && "upload(THostData *input) gave mismatched value type.");
-        std::memcpy(data_->data(), input, data_size_ * sizeof(value_type));
+        std::memcpy(ring_data_[ring_.previous()]->data(), input, data_size_ * sizeof(value_type));
       }
 
       // Assumes that THostData is a pointer to a value_type
@@ -316,7 +353,15 @@ namespace gearshifft
       {
         static_assert(std::is_same<THostData,value_type>::value
                       && "download(THostData *output) gave mismatched value type.");
-        std::memcpy(output, data_->data(), data_size_ * sizeof(value_type));
+        std::memcpy(output, ring_data_[ring_.previous()]->data(), data_size_ * sizeof(value_type));
+      }
+
+    private:
+
+      void select(size_t pair)
+      {
+        data_ = ring_data_[pair];
+        data_complex_ = ring_complex_[pair];
       }
     };
 
@@ -8,17 +8,29 @@
 #include "core/timer.hpp"
 #include "core/fft.hpp"
 #include "core/benchmark_suite.hpp"
+#include "core/buffer_ring.hpp"
+#include "core/cpu_placement.hpp"
+#include "core/huge_pages.hpp"
 #include "core/get_memory_size.hpp"
 #include "core/unused.hpp"
 
 #include <algorithm>
 #include <array>
+#include <cctype>
+#include <cstdio>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
 #include <sstream>
 #include <thread>
 #include <type_traits>
 #include <vector>
 
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
 #ifdef USE_ESSL
 #include <fftw3_essl.h>
 #else
@@ -52,24 +64,99 @@ namespace fftw {
 
     FftwOptions() : OptionsDefault() {
       add_options()
-        ("rigor", value(&rigor_)->default_value("measure"), "FFTW rigor (measure, estimate, wisdom, patient or exhaustive)")
+        ("rigor", value(&rigor_)->default_value("measure"), "FFTW rigor (measure, estimate, wisdom, patient or exhaustive), a list (e.g. estimate,measure,patient) runs each benchmark once per rigor and writes a break-even table.")
         ("wisdom_sp", value(&wisdom_sp_), "Wisdom file for single-precision.")
         ("wisdom_dp", value(&wisdom_dp_), "Wisdom file for double-precision.")
-        ("plan_timelimit", value(&plan_timelimit_)->default_value(-1.0), "Timelimit in seconds for planning in FFTW.");
+        ("plan_timelimit", value(&plan_timelimit_)->default_value("-1"), "Timelimit in seconds for planning in FFTW (<=0: none), a list (e.g. -1,0.01) runs each benchmark once per rigor and timelimit.")
+        ("wisdom_mode", value(&wisdom_mode_)->default_value("clear"), "FFTW wisdom between runs and benchmarks (clear or keep). clear forgets the wisdom when a plan is destroyed, keep accumulates it over all benchmarks (implied by --wisdom_cache).")
+        ("wisdom_cache", value(&wisdom_cache_)->default_value(""), "Directory of a persistent FFTW wisdom cache, imported at startup and updated after each benchmark, one file per host, CPU model, FFTW version and precision. The export time is recorded as Time_WisdomExport.");
+    }
+
+    /// directory of the wisdom cache (--wisdom_cache), empty if disabled
+    std::string getWisdomCache() const override {
+      return wisdom_cache_;
+    }
+
+    /// true if wisdom is kept between runs and benchmarks (--wisdom_mode keep or --wisdom_cache)
+    bool keep_wisdom() const {
+      if(wisdom_mode_ != "keep" && wisdom_mode_ != "clear")
+        throw std::runtime_error("Invalid FFTW wisdom mode.");
+      return wisdom_mode_ == "keep" || !getWisdomCache().empty();
+    }
+
+    /**
+     * Planner variants, one benchmark per rigor and timelimit.
+     * Named by the rigor, followed by "_tl<seconds>" if there is a timelimit,
+     * variants with the same name (repeated rigors) are registered once.
+     */
+    std::vector<std::string> getPlanners() const override {
+      const auto rigors = split(rigor_);
+      if(rigors.empty())
+        throw std::runtime_error("Invalid FFTW rigor.");
+      std::vector<std::string> planners;
+      for(const auto& rigor : rigors) {
+        for(double timelimit : plan_timelimits()) {
+          std::ostringstream planner;
+          planner << rigor;
+          if(timelimit > 0.0)
+            planner << "_tl" << timelimit;
+          if(std::find(planners.begin(), planners.end(), planner.str()) == planners.end())
+            planners.push_back(planner.str());
+        }
+      }
+      return planners;
+    }
+
+    /// planner of the current benchmark (first one before the benchmarks)
+    std::string planner() const {
+      return getPlanner().empty() ? getPlanners().front() : getPlanner();
     }
 
+    /// timelimit [s] of the current benchmark, FFTW_NO_TIMELIMIT if none
     double plan_timelimit() const {
+      std::string planner = this->planner();
+      auto pos = planner.find("_tl");
+      return pos == std::string::npos ? FFTW_NO_TIMELIMIT : std::stod(planner.substr(pos+3));
+    }
+
+    /// distinct values of --plan_timelimit, all values <= 0 are one "no limit" (-1)
+    std::vector<double> plan_timelimits() const {
+      std::vector<double> timelimits;
+      for(const auto& token : split(plan_timelimit_)) {
+        double timelimit;
+        try {
+          timelimit = std::stod(token);
+        } catch(const std::logic_error&) {
+          throw std::runtime_error("Invalid FFTW plan timelimit '"+token+"'.");
+        }
+        if(timelimit <= 0.0)
+          timelimit = FFTW_NO_TIMELIMIT;
+        if(std::find(timelimits.begin(), timelimits.end(), timelimit) == timelimits.end())
+          timelimits.push_back(timelimit);
+      }
+      if(timelimits.empty())
+        throw std::runtime_error("Invalid FFTW plan timelimit.");
+      return timelimits;
+    }
+
+    std::string plan_timelimit_str() const {
       return plan_timelimit_;
     }
 
+    /// rigor of the current benchmark
     unsigned plan_rigor() const {
-      if(rigor_ == "measure")
+      std::string planner = this->planner();
+      return plan_rigor(planner.substr(0, planner.find("_tl")));
+    }
+
+    static unsigned plan_rigor(const std::string& rigor) {
+      if(rigor == "measure")
         return FFTW_MEASURE;
-      if(rigor_ == "estimate")
+      if(rigor == "estimate")
         return FFTW_ESTIMATE;
-      if(rigor_ == "patient")
+      if(rigor == "patient")
         return FFTW_PATIENT;
-      if(rigor_ == "wisdom"){
+      if(rigor == "wisdom"){
         if(!native_fftw()) {
 #if defined (USE_ESSL)
           throw std::runtime_error("wisdom rigor not supported with ESSL wrappers.");
@@ -85,7 +172,7 @@ namespace fftw {
         return 0;   // FFTW_WISDOM_ONLY is not defined for ESSL -- but this line won't be reached.
 #endif
       }
-      if(rigor_ == "exhaustive")
+      if(rigor == "exhaustive")
         return FFTW_EXHAUSTIVE;
       throw std::runtime_error("Invalid FFTW rigor.");
     }
@@ -105,10 +192,25 @@ namespace fftw {
 
   private:
 
-    double plan_timelimit_ = -1;
+    /// comma separated list without empty elements
+    static std::vector<std::string> split(const std::string& list) {
+      std::vector<std::string> tokens;
+      std::istringstream ss(list);
+      std::string token;
+      while(std::getline(ss, token, ',')) {
+        token.erase(std::remove_if(token.begin(), token.end(), ::isspace), token.end());
+        if(!token.empty())
+          tokens.push_back(token);
+      }
+      return tokens;
+    }
+
+    std::string plan_timelimit_;
     std::string rigor_;
     std::string wisdom_sp_;
     std::string wisdom_dp_;
+    std::string wisdom_mode_;
+    std::string wisdom_cache_;
   };
 
   namespace traits{
@@ -173,6 +275,61 @@ namespace fftw {
       }
     };
 
+    template <typename T>
+    struct wisdom_api {};
+
+    template <>
+    struct wisdom_api<double> {
+      static void forget(){
+#ifndef USE_ESSL
+        fftw_forget_wisdom();
+#endif
+      }
+
+#ifndef USE_ESSL
+      static int import_system() { return fftw_import_system_wisdom(); }
+
+      static int import_file(const std::string& filename) {
+        return fftw_import_wisdom_from_filename(filename.c_str());
+      }
+
+      static std::string export_string() {
+        char* str = fftw_export_wisdom_to_string();
+        std::string wisdom = str ? str : "";
+        fftw_free(str);
+        return wisdom;
+      }
+
+      static std::string version() { return fftw_version; }
+#endif
+    };
+
+    template <>
+    struct wisdom_api<float> {
+      static void forget(){
+#ifndef USE_ESSL
+        fftwf_forget_wisdom();
+#endif
+      }
+
+#ifndef USE_ESSL
+      static int import_system() { return fftwf_import_system_wisdom(); }
+
+      static int import_file(const std::string& filename) {
+        return fftwf_import_wisdom_from_filename(filename.c_str());
+      }
+
+      static std::string export_string() {
+        char* str = fftwf_export_wisdom_to_string();
+        std::string wisdom = str ? str : "";
+        fftwf_free(str);
+        return wisdom;
+      }
+
+      static std::string version() { return fftwf_version; }
+#endif
+    };
+
     //http://www.fftw.org/fftw3_doc/Usage-of-Multi_002dthreaded-FFTW.html
     template <typename T>
     struct thread_api {};
@@ -190,8 +347,7 @@ namespace fftw {
 #endif
       }
 
-      static void plan_with_threads(int nthreads = -1,
-                                    double timelimit=FFTW_NO_TIMELIMIT){
+      static void plan_with_threads(int nthreads = -1){
 #ifndef USE_ESSL
         int av_procs = std::thread::hardware_concurrency();
 
@@ -199,7 +355,6 @@ namespace fftw {
           nthreads = av_procs;
 
         fftw_plan_with_nthreads(nthreads);
-        fftw_set_timelimit(timelimit);
 #endif
       }
 
@@ -223,8 +378,7 @@ namespace fftw {
 #endif
       }
 
-      static void plan_with_threads(int nthreads = -1,
-                                    double timelimit=FFTW_NO_TIMELIMIT){
+      static void plan_with_threads(int nthreads = -1){
 #ifndef USE_ESSL
         int av_procs = std::thread::hardware_concurrency();
 
@@ -232,7 +386,6 @@ namespace fftw {
           nthreads = av_procs;
 
         fftwf_plan_with_nthreads(nthreads);
-        fftwf_set_timelimit(timelimit);
 #endif
       }
 
@@ -250,6 +403,36 @@ namespace fftw {
     };
 
 
+    /**
+     * Data layout for FFTW's advanced interface (fftw_plan_many_dft*).
+     *
+     * Real data of inplace transforms is padded in the last dimension,
+     * the transforms of a batch are stored consecutively.
+     */
+    template <size_t NDims>
+    struct many_layout {
+      std::array<int,NDims> n;
+      std::array<int,NDims> real_embed;
+      std::array<int,NDims> complex_embed;
+      int real_dist    = 1;
+      int complex_dist = 1;
+
+      many_layout(const std::array<std::size_t,NDims>& _shape, bool _inplace) {
+        for(size_t i = 0;i < NDims;++i) {
+          n[i] = _shape[i];
+          real_embed[i] = _shape[i];
+          complex_embed[i] = _shape[i];
+        }
+        complex_embed[NDims-1] = n[NDims-1]/2 + 1;
+        if(_inplace)
+          real_embed[NDims-1] = 2*complex_embed[NDims-1];
+        for(size_t i = 0;i < NDims;++i) {
+          real_dist *= real_embed[i];
+          complex_dist *= complex_embed[i];
+        }
+      }
+    };
+
     template<typename T_Precision=float>
     struct plan
     {
@@ -261,6 +444,19 @@ namespace fftw {
         fftwf_execute(_plan);
       }
 
+      /// new-array execute, the arrays must have the layout and alignment of the planned ones
+      static void execute(const PlanType _plan, RealType* _in, ComplexType* _out){
+        fftwf_execute_dft_r2c(_plan, _in, _out);
+      }
+
+      static void execute(const PlanType _plan, ComplexType* _in, RealType* _out){
+        fftwf_execute_dft_c2r(_plan, _in, _out);
+      }
+
+      static void execute(const PlanType _plan, ComplexType* _in, ComplexType* _out){
+        fftwf_execute_dft(_plan, _in, _out);
+      }
+
       static void destroy(PlanType _plan){
 
         if(_plan)
@@ -269,23 +465,38 @@ namespace fftw {
 
       }
 
+      /// time limit [s] of the following plans, FFTW_NO_TIMELIMIT for none
+      static void set_timelimit(double timelimit){
+#ifndef USE_ESSL
+        fftwf_set_timelimit(timelimit);
+#else
+        gearshifft::ignore_unused(timelimit);
+#endif
+      }
+
       template <size_t NDims>
       static PlanType create(const std::array<std::size_t,NDims>& _shape,
                              RealType* _in,
                              ComplexType* _out,
                              fftw_direction _dir = fftw_direction::forward,
-                             unsigned plan_flags = FFTW_MEASURE){
+                             unsigned plan_flags = FFTW_MEASURE,
+                             int _howmany = 1){
 
         gearshifft::ignore_unused(_dir);
-        std::array<int,NDims> converted;
-        for(size_t i = 0;i < NDims;++i)
-          converted[i] = _shape[i];
-
-        PlanType value = fftwf_plan_dft_r2c(NDims,
-                                            converted.data(),
-                                            _in,
-                                            _out,
-                                            plan_flags );
+        many_layout<NDims> layout(_shape, static_cast<void*>(_in)==static_cast<void*>(_out));
+
+        PlanType value = fftwf_plan_many_dft_r2c(NDims,
+                                                 layout.n.data(),
+                                                 _howmany,
+                                                 _in,
+                                                 layout.real_embed.data(),
+                                                 1,
+                                                 layout.real_dist,
+                                                 _out,
+                                                 layout.complex_embed.data(),
+                                                 1,
+                                                 layout.complex_dist,
+                                                 plan_flags );
         return value;
       }
 
@@ -294,18 +505,24 @@ namespace fftw {
                              ComplexType* _in,
                              RealType* _out,
                              fftw_direction _dir = fftw_direction::forward,
-                             unsigned plan_flags = FFTW_MEASURE){
+                             unsigned plan_flags = FFTW_MEASURE,
+                             int _howmany = 1){
 
         gearshifft::ignore_unused(_dir);
-        std::array<int,NDims> converted;
-        for(size_t i = 0;i < NDims;++i)
-          converted[i] = _shape[i];
-
-        PlanType value = fftwf_plan_dft_c2r(NDims,
-                                            converted.data(),
-                                            _in,
-                                            _out,
-                                            plan_flags );
+        many_layout<NDims> layout(_shape, static_cast<void*>(_in)==static_cast<void*>(_out));
+
+        PlanType value = fftwf_plan_many_dft_c2r(NDims,
+                                                 layout.n.data(),
+                                                 _howmany,
+                                                 _in,
+                                                 layout.complex_embed.data(),
+                                                 1,
+                                                 layout.complex_dist,
+                                                 _out,
+                                                 layout.real_embed.data(),
+                                                 1,
+                                                 layout.real_dist,
+                                                 plan_flags );
         return value;
       }
 
@@ -314,19 +531,24 @@ namespace fftw {
                              ComplexType* _in,
                              ComplexType* _out,
                              fftw_direction _dir = fftw_direction::forward,
-                             unsigned plan_flags = FFTW_MEASURE){
-
-        std::array<int,NDims> converted;
-        for(size_t i = 0;i < NDims;++i)
-          converted[i] = _shape[i];
-
-
-        PlanType value = fftwf_plan_dft(NDims,
-                                        converted.data(),
-                                        _in,
-                                        _out,
-                                        static_cast<int>(_dir),
-                                        plan_flags );
+                             unsigned plan_flags = FFTW_MEASURE,
+                             int _howmany = 1){
+
+        many_layout<NDims> layout(_shape, false);
+
+        PlanType value = fftwf_plan_many_dft(NDims,
+                                             layout.n.data(),
+                                             _howmany,
+                                             _in,
+                                             layout.real_embed.data(),
+                                             1,
+                                             layout.real_dist,
+                                             _out,
+                                             layout.real_embed.data(),
+                                             1,
+                                             layout.real_dist,
+                                             static_cast<int>(_dir),
+                                             plan_flags );
         return value;
       }
 
@@ -343,6 +565,19 @@ namespace fftw {
         fftw_execute(_plan);
       }
 
+      /// new-array execute, the arrays must have the layout and alignment of the planned ones
+      static void execute(const PlanType _plan, RealType* _in, ComplexType* _out){
+        fftw_execute_dft_r2c(_plan, _in, _out);
+      }
+
+      static void execute(const PlanType _plan, ComplexType* _in, RealType* _out){
+        fftw_execute_dft_c2r(_plan, _in, _out);
+      }
+
+      static void execute(const PlanType _plan, ComplexType* _in, ComplexType* _out){
+        fftw_execute_dft(_plan, _in, _out);
+      }
+
       static void destroy(PlanType _plan){
 
         if(_plan)
@@ -351,25 +586,39 @@ namespace fftw {
 
       }
 
+      /// time limit [s] of the following plans, FFTW_NO_TIMELIMIT for none
+      static void set_timelimit(double timelimit){
+#ifndef USE_ESSL
+        fftw_set_timelimit(timelimit);
+#else
+        gearshifft::ignore_unused(timelimit);
+#endif
+      }
+
       // //ND
       template <size_t NDims>
       static PlanType create(const std::array<std::size_t,NDims>& _shape,
                              RealType* _in,
                              ComplexType* _out,
                              fftw_direction _dir = fftw_direction::forward,
-                             unsigned plan_flags = FFTW_MEASURE){
+                             unsigned plan_flags = FFTW_MEASURE,
+                             int _howmany = 1){
 
         gearshifft::ignore_unused(_dir);
-        std::array<int,NDims> converted;
-        for(size_t i = 0;i < NDims;++i)
-          converted[i] = _shape[i];
-
-
-        PlanType value = fftw_plan_dft_r2c(NDims,
-                                           converted.data(),
-                                           _in,
-                                           _out,
-                                           plan_flags );
+        many_layout<NDims> layout(_shape, static_cast<void*>(_in)==static_cast<void*>(_out));
+
+        PlanType value = fftw_plan_many_dft_r2c(NDims,
+                                                layout.n.data(),
+                                                _howmany,
+                                                _in,
+                                                layout.real_embed.data(),
+                                                1,
+                                                layout.real_dist,
+                                                _out,
+                                                layout.complex_embed.data(),
+                                                1,
+                                                layout.complex_dist,
+                                                plan_flags );
         return value;
       }
 
@@ -378,19 +627,24 @@ namespace fftw {
                              ComplexType* _in,
                              RealType* _out,
                              fftw_direction _dir = fftw_direction::forward,
-                             unsigned plan_flags = FFTW_MEASURE){
+                             unsigned plan_flags = FFTW_MEASURE,
+                             int _howmany = 1){
 
         gearshifft::ignore_unused(_dir);
-        std::array<int,NDims> converted;
-        for(size_t i = 0;i < NDims;++i)
-          converted[i] = _shape[i];
-
-
-        PlanType value = fftw_plan_dft_c2r(NDims,
-                                           converted.data(),
-                                           _in,
-                                           _out,
-                                           plan_flags );
+        many_layout<NDims> layout(_shape, static_cast<void*>(_in)==static_cast<void*>(_out));
+
+        PlanType value = fftw_plan_many_dft_c2r(NDims,
+                                                layout.n.data(),
+                                                _howmany,
+                                                _in,
+                                                layout.complex_embed.data(),
+                                                1,
+                                                layout.complex_dist,
+                                                _out,
+                                                layout.real_embed.data(),
+                                                1,
+                                                layout.real_dist,
+                                                plan_flags );
         return value;
       }
 
@@ -399,19 +653,24 @@ namespace fftw {
                              ComplexType* _in,
                              ComplexType* _out,
                              fftw_direction _dir = fftw_direction::forward,
-                             unsigned plan_flags = FFTW_MEASURE){
+                             unsigned plan_flags = FFTW_MEASURE,
+                             int _howmany = 1){
 
-        std::array<int,NDims> converted;
-        for(size_t i = 0;i < NDims;++i)
-          converted[i] = _shape[i];
+        many_layout<NDims> layout(_shape, false);
 
-
-        PlanType value = fftw_plan_dft(NDims,
-                                       converted.data(),
-                                       _in,
-                                       _out,
-                                       static_cast<int>(_dir),
-                                       plan_flags );
+        PlanType value = fftw_plan_many_dft(NDims,
+                                            layout.n.data(),
+                                            _howmany,
+                                            _in,
+                                            layout.real_embed.data(),
+                                            1,
+                                            layout.real_dist,
+                                            _out,
+                                            layout.real_embed.data(),
+                                            1,
+                                            layout.real_dist,
+                                            static_cast<int>(_dir),
+                                            plan_flags );
         return value;
       }
 
@@ -421,9 +680,25 @@ namespace fftw {
 
   /**
    * FFTW context.
+   *
+   * Thread support of FFTW is initialized by create() and released with the
+   * planner state and the wisdom by destroy(), once for all benchmarks
+   * (timed as context creation and destruction).
    */
   struct FftwContext : public ContextDefault<FftwOptions> {
 
+    /// also imports the wisdom cache (--wisdom_cache), see WisdomCache
+    void create();
+
+    void destroy() {
+#if GEARSHIFFT_PRECISION_DOUBLE_ONLY!=1
+      cleanup<float>();
+#endif
+#if GEARSHIFFT_PRECISION_SINGLE_ONLY!=1
+      cleanup<double>();
+#endif
+    }
+
     static const std::string title() {
       if(native_fftw()){
         return "Fftw";}
@@ -473,14 +748,33 @@ namespace fftw {
           << ",\"UsedThreads\"," << ndevs
           << ",\"TotalMemory\"," << getMemorySize()
           << ",\"PlanRigor\",\"" << options().plan_rigor_str();
-      double plan_timelimit = options().plan_timelimit();
-      if(plan_timelimit > 0.0)
-        msg << "\",\"PlanTimeLimit [s]\"," << plan_timelimit;
+      auto plan_timelimits = options().plan_timelimits();
+      if(plan_timelimits.size() > 1)
+        msg << "\",\"PlanTimeLimit [s]\",\"" << options().plan_timelimit_str() << "\"";
+      else if(plan_timelimits.front() > 0.0)
+        msg << "\",\"PlanTimeLimit [s]\"," << plan_timelimits.front();
       else
         msg << "\",\"PlanTimeLimit [s]\"," << "\"None\"";
+      msg << ",\"WisdomMode\",\"" << (options().keep_wisdom() ? "keep" : "clear") << "\"";
+      if(!options().getWisdomCache().empty())
+        msg << ",\"WisdomCache\",\"" << options().getWisdomCache() << "\""
+            << ",\"WisdomImport [ms]\"," << timeWisdomImport_;
       return msg.str();
     }
 
+  private:
+    /// time of importing the wisdom cache at context creation
+    double timeWisdomImport_ = 0.0;
+
+    template<typename T_Precision>
+    static void cleanup() {
+#if defined(GEARSHIFFT_BACKEND_FFTW_THREADS) && GEARSHIFFT_BACKEND_FFTW_THREADS==1
+      traits::thread_api<T_Precision>::cleanup_threads();
+#else
+      traits::no_thread_api<T_Precision>::cleanup();
+#endif
+    }
+
   };
 
   template<typename T_Precision>
@@ -493,40 +787,184 @@ namespace fftw {
 
 #ifndef USE_ESSL
       std::string filename = FftwContext::options().wisdom_file<T_Precision>();
-      std::string source;
-      std::ifstream ifs;
-      std::stringstream ss;
-      std::string line;
-      ifs.open(filename.c_str(), std::ifstream::in);
-      if(!ifs.good())
+      if(!std::ifstream(filename).good())
         throw std::runtime_error("Wisdom file not accessable.");
+      if(!traits::wisdom_api<T_Precision>::import_file(filename))
+        throw std::runtime_error("Wisdom file could not be loaded.");
+#endif
+    }
 
-      if(ifs.is_open()) {
-        while ( getline (ifs,line) )
-        {
-          ss << line;
+  }; // FftwWisdomLoader
+
+  /**
+   * Managed wisdom cache (--wisdom_cache DIR).
+   *
+   * One file per host, CPU model, FFTW version and precision.
+   * load() imports the system wisdom and the cache file at context creation,
+   * save() exports the wisdom after the last run of a benchmark if it has
+   * changed since the last import or export.  Writers hold an exclusive lock (flock on <file>.lock)
+   * and import the file before exporting, so the wisdom of concurrent
+   * processes is merged.  The file is written to a temporary file and renamed,
+   * so readers never see a partial file.
+   * Wisdom is kept between runs and benchmarks if the cache is enabled.
+   */
+  template<typename T_Precision>
+  struct WisdomCache {
+
+    static bool isEnabled() {
+      return !FftwContext::options().getWisdomCache().empty();
+    }
+
+    static std::string filename() {
+      std::ostringstream name;
+      name << "wisdom_" << key(host()) << "_" << key(cpu_model())
+#ifndef USE_ESSL
+           << "_" << key(traits::wisdom_api<T_Precision>::version())
+#endif
+           << "_" << (std::is_same<T_Precision, float>::value ? "float" : "double");
+      return (std::filesystem::path(FftwContext::options().getWisdomCache()) / name.str()).string();
+    }
+
+    /// imports system wisdom and cache file, returns the time in ms
+    static double load() {
+      TimerCPU timer;
+      timer.startTimer();
+#ifndef USE_ESSL
+      std::filesystem::create_directories(FftwContext::options().getWisdomCache());
+      traits::wisdom_api<T_Precision>::import_system();
+      const std::string file = filename();
+      if(std::ifstream(file).good() && !traits::wisdom_api<T_Precision>::import_file(file))
+        std::cerr << "gearshifft: wisdom cache " << file << " could not be imported.\n";
+      last() = traits::wisdom_api<T_Precision>::export_string();
+#endif
+      return timer.stopTimer();
+    }
+
+    /// exports the wisdom if it has changed, returns the time in ms
+    static double save() {
+      TimerCPU timer;
+      timer.startTimer();
+#ifndef USE_ESSL
+      static std::mutex mutex;
+      std::lock_guard<std::mutex> lock(mutex);
+      if(traits::wisdom_api<T_Precision>::export_string() != last()) {
+        const std::string file = filename();
+        FileLock file_lock(file + ".lock");
+        // merge the wisdom other processes wrote since our import
+        if(std::ifstream(file).good())
+          traits::wisdom_api<T_Precision>::import_file(file);
+        std::string wisdom = traits::wisdom_api<T_Precision>::export_string();
+        const std::string tmp = file + ".tmp" + std::to_string(getpid());
+        std::ofstream out(tmp, std::ios::trunc);
+        out << wisdom;
+        out.close();
+        if(!out || std::rename(tmp.c_str(), file.c_str()) != 0) {
+          std::remove(tmp.c_str());
+          throw std::runtime_error("Wisdom cache "+file+" could not be written.");
         }
-        ifs.close();
-        source = ss.str();
+        last() = std::move(wisdom);
       }
-
-      int imported = 0;
-      if(std::is_same<T_Precision,float>::value)
-        imported = fftwf_import_wisdom_from_string(source.c_str());
-      if(std::is_same<T_Precision,double>::value)
-        imported = fftw_import_wisdom_from_string(source.c_str());
-      if(!imported)
-        throw std::runtime_error("Wisdom file could not be loaded.");
 #endif
+      return timer.stopTimer();
     }
 
-  }; // FftwWisdomLoader
+  private:
+    /// exclusive advisory lock of a file, held until destruction
+    class FileLock {
+    public:
+      explicit FileLock(const std::string& path)
+        : fd_(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) {
+        if(fd_ >= 0 && ::flock(fd_, LOCK_EX) != 0) {
+          ::close(fd_);
+          fd_ = -1;
+        }
+        if(fd_ < 0)
+          throw std::runtime_error("Wisdom cache lock "+path+" could not be acquired.");
+      }
+      ~FileLock() {
+        ::flock(fd_, LOCK_UN);
+        ::close(fd_);
+      }
+      FileLock(const FileLock&) = delete;
+      FileLock& operator=(const FileLock&) = delete;
+    private:
+      int fd_;
+    };
+
+    /// wisdom of the last import or export
+    static std::string& last() {
+      static std::string wisdom;
+      return wisdom;
+    }
+
+    /// file name part, characters other than alphanumerics, '.' and '-' are replaced
+    static std::string key(std::string s) {
+      for(auto& c : s) {
+        if(!std::isalnum(static_cast<unsigned char>(c)) && c != '.' && c != '-')
+          c = '-';
+      }
+      return s.empty() ? "unknown" : s;
+    }
+
+    static std::string host() {
+      char name[256] = {0};
+      if(gethostname(name, sizeof(name)-1) != 0)
+        return "";
+      return name;
+    }
+
+    static std::string cpu_model() {
+      std::ifstream cpuinfo("/proc/cpuinfo");
+      std::string line;
+      while(std::getline(cpuinfo, line)) {
+        if(line.compare(0, 10, "model name") == 0 || line.compare(0, 8, "CPU part") == 0) {
+          auto value = line.find_first_not_of(" \t", line.find(':')+1);
+          if(line.find(':') != std::string::npos && value != std::string::npos)
+            return line.substr(value);
+        }
+      }
+      return "";
+    }
+  };
+
+  inline void FftwContext::create() {
+    // validates wisdom mode, rigors and timelimits
+    const bool keep_wisdom = options().keep_wisdom();
+    const auto planners = options().getPlanners();
+    for(const auto& planner : planners)
+      FftwOptions::plan_rigor(planner.substr(0, planner.find("_tl")));
+    if(keep_wisdom && planners.size() > 1)
+      std::cerr << "gearshifft: wisdom is kept across the planner sweep, plans of a higher rigor are reused by lower ones.\n";
+#if defined(GEARSHIFFT_BACKEND_FFTW_THREADS) && GEARSHIFFT_BACKEND_FFTW_THREADS==1
+#if GEARSHIFFT_PRECISION_DOUBLE_ONLY!=1
+    if( traits::thread_api<float>::init_threads()==0 )
+      throw std::runtime_error("fftw thread initialization failed.");
+#endif
+#if GEARSHIFFT_PRECISION_SINGLE_ONLY!=1
+    if( traits::thread_api<double>::init_threads()==0 )
+      throw std::runtime_error("fftw thread initialization failed.");
+#endif
+#endif
+    if(options().getWisdomCache().empty())
+      return;
+    if(!native_fftw())
+      throw std::runtime_error("Wisdom cache is only supported by native fftw.");
+#if GEARSHIFFT_PRECISION_DOUBLE_ONLY!=1
+    timeWisdomImport_ += WisdomCache<float>::load();
+#endif
+#if GEARSHIFFT_PRECISION_SINGLE_ONLY!=1
+    timeWisdomImport_ += WisdomCache<double>::load();
+#endif
+  }
 
   /**
    * Fftw plan and execution class.
    *
    * This class handles:
    * - {1D, 2D, 3D} x {R2C, C2R, C2C} x {inplace, outplace} x {float, double}.
+   * - batches of transforms stored consecutively, planned with fftw_plan_many_dft*.
+   * - a ring of buffer pairs (--buffer-ring) in one allocation, the pairs are
+   *   transformed with the new-array execute functions (see BufferRing).
    */
   template<typename TFFT, // see fft.hpp (FFT_Inplace_Real, ...)
            typename TPrecision, // double, float
@@ -566,6 +1004,8 @@ namespace fftw {
     size_t n_         = 0;
     /// product of corresponding extents
     size_t n_complex_ = 0;
+    /// number of transforms per plan
+    size_t batch_     = 1;
 
     PlanType      fwd_plan_          = nullptr;
     PlanType      bwd_plan_          = nullptr;
@@ -575,10 +1015,14 @@ namespace fftw {
     size_t        data_size_         = 0;
     /// size in bytes of FFT(input) for out-of-place transforms
     size_t        data_complex_size_ = 0;
+    /// buffer pairs if --buffer-ring is enabled, the first pair is data_ and data_complex_
+    BufferRing    ring_;
+    /// distance in bytes between the buffer pairs (0 without ring)
+    size_t        ring_stride_       = 0;
 
     unsigned plan_rigor_ = FftwContext::options().plan_rigor();
 
-    FftwImpl(const Extent& cextents) {
+    FftwImpl(const Extent& cextents, size_t batch = 1) : batch_(batch) {
         extents_ = interpret_as::column_major(cextents);
         extents_complex_ = extents_;
 
@@ -596,28 +1040,38 @@ namespace fftw {
                                      1,
                                      std::multiplies<size_t>());
 
-        data_size_ = (IsInplaceReal ? 2*n_complex_ : n_) * sizeof(value_type);
+        data_size_ = batch_ * (IsInplaceReal ? 2*n_complex_ : n_) * sizeof(value_type);
         if(!IsInplace)
-          data_complex_size_ = n_complex_ * sizeof(ComplexType);
+          data_complex_size_ = batch_ * n_complex_ * sizeof(ComplexType);
+
+        // pairs are 64 byte aligned, so all pairs have the alignment of the planned one
+        if(BufferRing::isEnabled()) {
+          ring_stride_ = align64(data_size_) + align64(data_complex_size_);
+          ring_ = BufferRing(BufferRing::count(ring_stride_));
+        }
+        const size_t ring_size = (ring_.size()-1) * ring_stride_;
 
         //size_t total_mem = getMemorySize();
         size_t total_mem = 95*getMemorySize()/100; // keep some memory available, otherwise an out-of-memory killer becomes more likely
-        if(total_mem < 3*data_size_+data_complex_size_) { // includes host input buffers
+        if(total_mem < 3*data_size_+data_complex_size_+ring_size) { // includes host input buffers
           std::stringstream ss;
-          ss << total_mem << "<" << 3*data_size_+data_complex_size_ << " (bytes)";
+          ss << total_mem << "<" << 3*data_size_+data_complex_size_+ring_size << " (bytes)";
           throw std::runtime_error("FFT data exceeds physical memory. "+ss.str());
         }
 
+        // threads are initialized by FftwContext, the number of threads may differ per benchmark
 #if defined(GEARSHIFFT_BACKEND_FFTW_THREADS) && GEARSHIFFT_BACKEND_FFTW_THREADS==1
         #ifdef GEARSHIFFT_BACKEND_FFTW_OPENMP
                 omp_set_num_threads(FftwContext::options().getNumberDevices());
         #endif
-        if( traits::thread_api<TPrecision>::init_threads()==0 )
-          throw std::runtime_error("fftw thread initialization failed.");
-
         traits::thread_api<TPrecision>::plan_with_threads(FftwContext::options().getNumberDevices());
+        CpuPlacement::get().apply(FftwContext::options().getNumberDevices());
+#else
+        CpuPlacement::get().apply(1);
 #endif
 
+        PlanAPI::set_timelimit(FftwContext::options().plan_timelimit());
+
 #ifndef USE_ESSL
         if(plan_rigor_ == FFTW_WISDOM_ONLY && native_fftw()) {
           ImportWisdom<TPrecision>()();
@@ -628,11 +1082,8 @@ namespace fftw {
     ~FftwImpl(){
 
       destroy();
-#if defined(GEARSHIFFT_BACKEND_FFTW_THREADS) && GEARSHIFFT_BACKEND_FFTW_THREADS==1
-      traits::thread_api<TPrecision>::cleanup_threads();
-#else
-      traits::no_thread_api<TPrecision>::cleanup();
-#endif
+      if(!FftwContext::options().keep_wisdom())
+        traits::wisdom_api<TPrecision>::forget();
     }
 
     /**
@@ -650,7 +1101,8 @@ namespace fftw {
                                   data_,
                                   data_complex_,
                                   traits::fftw_direction::forward,
-                                  plan_rigor_);
+                                  plan_rigor_,
+                                  static_cast<int>(batch_));
       if(!fwd_plan_) {
 #ifndef USE_ESSL
         if(plan_rigor_ == FFTW_WISDOM_ONLY) {
@@ -669,7 +1121,8 @@ namespace fftw {
                                   data_complex_,
                                   data_,
                                   traits::fftw_direction::inverse,
-                                  plan_rigor_);
+                                  plan_rigor_,
+                                  static_cast<int>(batch_));
       if(!bwd_plan_) {
 #ifndef USE_ESSL
         if(plan_rigor_ == FFTW_WISDOM_ONLY) {
@@ -700,36 +1153,127 @@ namespace fftw {
      */
     size_t get_transfer_size() {
       // when inplace-real then alloc'd data is bigger than data to be transferred
-      return IsInplaceReal ? n_*sizeof(RealType) : data_size_;
+      return IsInplaceReal ? batch_*n_*sizeof(RealType) : data_size_;
     }
 
     //////////////////////////////////////////////////////////////////////////////////////
     // --- next methods are benchmarked ---
 
     void allocate() {
-      data_ = static_cast<value_type*>(MemoryAPI::malloc(data_size_));
+      if(ring_stride_) {
+        // all pairs in one block, data and complex data of a pair are adjacent
+        char* block = static_cast<char*>(malloc(ring_.size() * ring_stride_));
+        data_ = reinterpret_cast<value_type*>(block);
+        data_complex_ = IsInplace ? reinterpret_cast<ComplexType*>(block)
+                                  : reinterpret_cast<ComplexType*>(block + align64(data_size_));
+        CpuPlacement::get().bind(block, ring_.size() * ring_stride_);
+        ring_ = BufferRing(ring_.size());
+        return;
+      }
+      data_ = static_cast<value_type*>(malloc(data_size_));
       if(IsInplace){
         data_complex_ = reinterpret_cast<ComplexType*>(data_);
       }
       else{
-        data_complex_ = static_cast<ComplexType*>(MemoryAPI::malloc(data_complex_size_));
+        data_complex_ = static_cast<ComplexType*>(malloc(data_complex_size_));
+      }
+      CpuPlacement::get().bind(data_, data_size_);
+      if(!IsInplace)
+        CpuPlacement::get().bind(data_complex_, data_complex_size_);
+    }
+
+    /**
+     * Fills all buffer pairs of the ring with the input (--buffer-ring, not timed),
+     * returns the number of pairs.
+     */
+    template<typename THostData>
+    size_t prime(THostData* input) {
+      if(ring_stride_ && !ring_.isPrimed()) {
+        for(size_t i = 0; i < ring_.size(); ++i)
+          copy_in(ring_data(ring_.fillOrder(i)), input);
+        ring_.setPrimed(true);
       }
+      return ring_.size();
+    }
+
+
+    /// page size [bytes] backing the FFT buffers (see --hugepages)
+    double get_page_size() const {
+      return HugePages::pageSize(data_);
     }
 
+    /// exports the wisdom to the cache (--wisdom_cache, not timed), returns the time [ms]
+    static double export_wisdom() {
+      return WisdomCache<TPrecision>::isEnabled() ? WisdomCache<TPrecision>::save() : 0.0;
+    }
 
     void execute_forward() {
-      PlanAPI::execute(fwd_plan_);
+      if(ring_stride_)
+        PlanAPI::execute(fwd_plan_, ring_data(ring_.current()), ring_complex(ring_.current()));
+      else
+        PlanAPI::execute(fwd_plan_);
     }
 
     void execute_inverse() {
-      PlanAPI::execute(bwd_plan_);
+      if(ring_stride_) {
+        PlanAPI::execute(bwd_plan_, ring_complex(ring_.current()), ring_data(ring_.current()));
+        ring_.advance();
+      } else {
+        PlanAPI::execute(bwd_plan_);
+      }
     }
 
+    /// refills the pair executed last (the only pair without ring)
     template<typename THostData>
     void upload(THostData* input) {
+      copy_in(ring_data(ring_.previous()), input);
+    }
+
+    /// reads the pair executed last (the only pair without ring)
+    template<typename THostData>
+    void download(THostData* output) {
+      copy_out(output, ring_data(ring_.previous()));
+    }
+
+    void destroy() {
+
+      if(data_)
+        free(data_);
+      data_ = nullptr;
+
+      if(data_complex_ && !IsInplace && !ring_stride_)
+        free(data_complex_);
+      data_complex_ = nullptr;
+
+      if(fwd_plan_)
+        PlanAPI::destroy(fwd_plan_);
+      fwd_plan_ = nullptr;
+
+      if(bwd_plan_)
+        PlanAPI::destroy(bwd_plan_);
+      bwd_plan_ = nullptr;
+
+    }
+
+  private:
+
+    static size_t align64(size_t nbytes) {
+      return (nbytes + 63) / 64 * 64;
+    }
+
+    value_type* ring_data(size_t pair) {
+      return reinterpret_cast<value_type*>(reinterpret_cast<char*>(data_) + pair*ring_stride_);
+    }
+
+    ComplexType* ring_complex(size_t pair) {
+      return reinterpret_cast<ComplexType*>(reinterpret_cast<char*>(data_complex_) + pair*ring_stride_);
+    }
+
+    template<typename THostData>
+    void copy_in(value_type* data, THostData* input) {
 
       if(!IsInplaceReal){
-        MemoryAPI::memcpy(data_, input, data_size_);
+        MemoryAPI::memcpy(data, input, data_size_);
       } else {
         const std::size_t max_z = (NDim >= 3 ? extents_[NDim-3] : 1);
         const std::size_t max_y = (NDim >= 2 ? extents_[NDim-2] : 1);
@@ -739,23 +1283,25 @@ namespace fftw {
         std::size_t input_index = 0;
         std::size_t data_index = 0;
 
-        for(std::size_t z = 0;z < max_z;++z){
-          for(std::size_t y = 0;y < max_y;++y){
-            input_index = z*(max_y*max_x) + y*max_x;
-            data_index = z*(max_y*allocated_x) + y*allocated_x;
-            MemoryAPI::memcpy(data_ + data_index,
-                              input + input_index,
-                              max_x * sizeof(value_type));
+        for(std::size_t b = 0;b < batch_;++b){
+          for(std::size_t z = 0;z < max_z;++z){
+            for(std::size_t y = 0;y < max_y;++y){
+              input_index = ((b*max_z + z)*max_y + y)*max_x;
+              data_index = ((b*max_z + z)*max_y + y)*allocated_x;
+              MemoryAPI::memcpy(data + data_index,
+                                input + input_index,
+                                max_x * sizeof(value_type));
+            }
           }
         }
       }
     }
 
     template<typename THostData>
-    void download(THostData* output) {
+    void copy_out(THostData* output, const value_type* data) {
 
       if(!IsInplaceReal){
-        MemoryAPI::memcpy(output, data_, data_size_);
+        MemoryAPI::memcpy(output, data, data_size_);
       } else {
         const std::size_t max_z = (NDim >= 3 ? extents_[NDim-3] : 1);
         const std::size_t max_y = (NDim >= 2 ? extents_[NDim-2] : 1);
@@ -765,37 +1311,33 @@ namespace fftw {
         std::size_t output_index = 0;
         std::size_t data_index = 0;
 
-        for(std::size_t z = 0;z < max_z;++z){
-          for(std::size_t y = 0;y < max_y;++y){
-            output_index = z*(max_y*max_x) + y*max_x;
-            data_index = z*(max_y*allocated_x) + y*allocated_x;
-            MemoryAPI::memcpy(output+output_index,
-                              data_ + data_index,
-                              max_x * sizeof(value_type));
+        for(std::size_t b = 0;b < batch_;++b){
+          for(std::size_t z = 0;z < max_z;++z){
+            for(std::size_t y = 0;y < max_y;++y){
+              output_index = ((b*max_z + z)*max_y + y)*max_x;
+              data_index = ((b*max_z + z)*max_y + y)*allocated_x;
+              MemoryAPI::memcpy(output+output_index,
+                                data + data_index,
+                                max_x * sizeof(value_type));
+            }
           }
         }
       }
 
     }
 
-    void destroy() {
-
-      if(data_)
-        MemoryAPI::free(data_);
-      data_ = nullptr;
-
-      if(data_complex_ && !IsInplace)
-        MemoryAPI::free(data_complex_);
-      data_complex_ = nullptr;
-
-      if(fwd_plan_)
-        PlanAPI::destroy(fwd_plan_);
-      fwd_plan_ = nullptr;
-
-      if(bwd_plan_)
-        PlanAPI::destroy(bwd_plan_);
-      bwd_plan_ = nullptr;
+    /// huge pages if enabled, fftw_malloc otherwise
+    static void* malloc(size_t nbytes) {
+      if(HugePages::enabled())
+        return HugePages::allocate(nbytes, 64);
+      return MemoryAPI::malloc(nbytes);
+    }
 
+    static void free(void* p) {
+      if(HugePages::enabled())
+        HugePages::deallocate(p);
+      else
+        MemoryAPI::free(p);
     }
   };
 
@@ -0,0 +1,88 @@
+// Interposes the allocation functions of the C library to feed AllocTracker (--track-allocs).
+// Definitions in the executable take precedence over libc for all shared libraries,
+// the calls are forwarded to the glibc internal entry points.
+#include "core/alloc_tracker.hpp"
+
+#if defined(__GLIBC__)
+
+#include <cerrno>
+#include <cstddef>
+#include <malloc.h>
+
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t n, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void* __libc_memalign(size_t alignment, size_t size);
+  void* __libc_valloc(size_t size);
+  void* __libc_pvalloc(size_t size);
+  void __libc_free(void* ptr);
+}
+
+using gearshifft::AllocTracker;
+
+namespace {
+
+  void* counted(void* ptr) {
+    if(ptr && AllocTracker::isActive())
+      AllocTracker::allocated(malloc_usable_size(ptr));
+    return ptr;
+  }
+
+  struct Hooked {
+    Hooked() { AllocTracker::setHooked(); }
+  } hooked;
+}
+
+extern "C" {
+
+  void* malloc(size_t size) noexcept {
+    return counted(__libc_malloc(size));
+  }
+
+  void* calloc(size_t n, size_t size) noexcept {
+    return counted(__libc_calloc(n, size));
+  }
+
+  void* realloc(void* ptr, size_t size) noexcept {
+    const size_t old = ptr ? malloc_usable_size(ptr) : 0;
+    void* p = __libc_realloc(ptr, size);
+    if((p || !size) && old && AllocTracker::isActive())
+      AllocTracker::freed(old);
+    return counted(p);
+  }
+
+  void free(void* ptr) noexcept {
+    if(ptr && AllocTracker::isActive())
+      AllocTracker::freed(malloc_usable_size(ptr));
+    __libc_free(ptr);
+  }
+
+  void* memalign(size_t alignment, size_t size) noexcept {
+    return counted(__libc_memalign(alignment, size));
+  }
+
+  void* aligned_alloc(size_t alignment, size_t size) noexcept {
+    return counted(__libc_memalign(alignment, size));
+  }
+
+  int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+    if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+      return EINVAL;
+    void* p = __libc_memalign(alignment, size);
+    if(!p && size)
+      return ENOMEM;
+    *ptr = counted(p);
+    return 0;
+  }
+
+  void* valloc(size_t size) noexcept {
+    return counted(__libc_valloc(size));
+  }
+
+  void* pvalloc(size_t size) noexcept {
+    return counted(__libc_pvalloc(size));
+  }
+}
+
+#endif
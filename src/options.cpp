@@ -1,11 +1,18 @@
 #include "core/application.hpp"
 #include "core/options.hpp"
+#include "core/buffer_ring.hpp"
+#include "core/cpu_placement.hpp"
+#include "core/data_pattern.hpp"
+#include "core/huge_pages.hpp"
+#include "core/validation.hpp"
 
 #include <gearshifft_version.hpp>
 
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <cctype>
+#include <thread>
 #include <boost/program_options.hpp>
 #include <boost/algorithm/string.hpp>
 #include <boost/algorithm/string/predicate.hpp>
@@ -26,7 +33,34 @@ OptionsDefault::OptionsDefault() {
     ("verbose,v", "Prints benchmark statistics")
     ("version,V", "Prints gearshifft version")
     ("device,d", po::value<std::string>(&device_)->default_value("gpu"), "Compute device = (gpu|cpu|acc|<ID>). If device is not supported by FFT lib, then it is ignored and default is used.")
-    ("ndevices,n", po::value<size_t>(&ndevices_)->default_value(0), "Number of devices (0=all), if supported by FFT lib (e.g. clfft and fftw with n CPU threads).")
+    ("ndevices,n", po::value<std::string>(&ndevicesStr_)->default_value("0"), "Number of devices (0=all, 1 per stream with --streams), if supported by FFT lib (e.g. clfft and fftw with n CPU threads). A list or range (eg. 1,2,4 or 1..max:x2) runs each benchmark per value.")
+    ("runs", po::value<int>(&warmRuns_)->default_value(GEARSHIFFT_NUMBER_WARM_RUNS), "Number of benchmark runs after warmup.")
+    ("warmups", po::value<int>(&warmups_)->default_value(GEARSHIFFT_NUMBER_WARMUPS), "Number of warmup runs before the benchmark runs.")
+    ("target-ci", po::value<std::string>(&targetCIStr_)->default_value(""), "Adaptive mode: repeat runs until the relative 95% confidence interval of FFT and iFFT times is below target (e.g. 1%). Warmup is detected automatically.")
+    ("max-runs", po::value<int>(&maxRuns_)->default_value(100), "Adaptive mode: maximum number of runs (incl. warmups) per benchmark.")
+    ("max-time", po::value<double>(&maxTime_)->default_value(0.0), "Adaptive mode: maximum time per benchmark in seconds (0=no limit).")
+    ("steady-state", "Plan once: client, memory and plans are created by the first run of a benchmark and reused by the following runs, which only time upload, FFT, iFFT and download.")
+    ("latency", po::value<int>(&latencySamples_)->default_value(0), "Latency mode: number of timed FFT and iFFT executions per run, recorded into histograms (p50/p90/p99/p99.9/max).")
+    ("latency-histogram", po::value<std::string>(&latencyHistogramFile_)->default_value(""), "Latency mode: csv file for the full histograms of each run.")
+    ("timer", po::value<std::string>(&timer_)->default_value("chrono"), "Timer of the CPU time measurements (chrono|tsc). tsc reads the time stamp counter (x86, invariant TSC), calibrated at startup, its overhead is subtracted.")
+    ("inner-time", po::value<double>(&innerTime_)->default_value(0.0), "Inner repetition for short transforms: FFT and iFFT are executed back-to-back until a timed step takes at least the given time in ms (count calibrated per benchmark), the time per transform is recorded (0=single execution). Unnormalized transforms restore their input every few executions to avoid overflows (e.g. every 6 at 1024 points in single precision), each chunk is timed separately and the calibrated timer overhead is subtracted, so very short transforms keep some timer overhead.")
+    ("validate", po::value<std::string>(&validate_)->default_value("every"), "Validation of the round trip results (every|first|last|sample:N|stride:K): all runs, first or last run, every N-th run or every K-th element. Runs and elements not compared are checked for NaN/Inf.")
+    ("data", po::value<std::string>(&data_)->default_value("sawtooth"), "Input signal (sawtooth|uniform|gaussian|impulse|chirp|denormal-heavy), random signals are reproducible with --seed.")
+    ("seed", po::value<uint64_t>(&seed_)->default_value(0), "Seed of the random input signals.")
+    ("ftz", "Flush denormal results to zero (x86 MXCSR).")
+    ("daz", "Treat denormal operands as zero (x86 MXCSR).")
+    ("flush-cache", po::value<bool>(&flushCache_)->default_value(flushCache_)->implicit_value(true), "Evict the caches before each plan and execution step (cache sizes from sysfs), the flush time is recorded as Time_Flush.")
+    ("buffer-ring", po::value<std::string>(&bufferRing_)->default_value("off"), "Cache-cold execution: rotate the transforms over a ring of buffer pairs exceeding the LLC (off|auto|<pairs>), if supported by FFT lib (fftw and eigen). The number of pairs is recorded as Buffers_Ring.")
+    ("perf-counters", "Read hardware performance counters (cycles, instructions, LLC/dTLB/branch misses) around upload, FFT, iFFT and download (Linux perf_event_open), including the threads of the FFT library.")
+    ("memory", "Record the resident set size (Linux /proc) around allocation, planning, execution and destroy, and its peak per run.")
+    ("os-noise", "Count context switches, CPU migrations, page faults (benchmark thread) and interrupts (all CPUs) around upload, FFT, iFFT and download.")
+    ("noise-threshold", po::value<double>(&noiseThreshold_)->default_value(0.0), "OS noise: runs with more involuntary context switches, migrations and major page faults are flagged (Noise_Flagged).")
+    ("track-allocs", "Count heap allocations (bytes and number) of planning, execution and destroy, e.g. plan and twiddle memory of the FFT library (malloc interposition, glibc, build with GEARSHIFFT_ALLOC_HOOK=ON).")
+    ("batch", po::value<std::string>(&batch_)->default_value("1"), "Number of transforms per plan (eg. 1,16,256 or 1..256:x2), one benchmark per value, if supported by FFT lib (e.g. fftw and eigen).")
+    ("streams", po::value<std::string>(&streamsStr_)->default_value("1"), "Number of concurrent FFT streams, each thread with its own FFT client and buffers (eg. 1,2,4 or 1..max:x2), one benchmark per value.")
+    ("numa-policy", po::value<std::string>(&numaPolicy_)->default_value("default"), "NUMA memory policy of the benchmark thread and CPU backend buffers (default|local|interleave|node:N).")
+    ("pin", po::value<std::string>(&pin_)->default_value("none"), "Pin benchmark and CPU backend threads (none|compact|scatter|<cpu list, eg. 0-3,8>), a benchmark with n threads uses the first n CPUs.")
+    ("hugepages", po::value<std::string>(&hugePages_)->default_value("off"), "Huge pages for host and CPU backend buffers (off|thp|hugetlb-2M|hugetlb-1G), hugetlb falls back to thp if no pages are reserved. If given, the page sizes obtained are recorded.")
     ("list-devices,l", "List of available compute devices with IDs, if supported.")
     ("list-benchmarks,b", "Show registered benchmarks")
     ("run-benchmarks,r", po::value<std::string>(), "Run specific benchmarks (wildcards possible, e.g. ClFFT/float/*/Inplace_Real)")
@@ -69,6 +103,94 @@ void OptionsDefault::parseExtent( const std::string& extent ) {
   }
 }
 
+/**
+ * Parses a list of positive numbers like "1,2,4" or ranges like "1..8" (step +1),
+ * "1..64:x2" (multiplied by 2) or "2..16:+2". "max" is the number of hardware threads.
+ */
+std::vector<size_t> OptionsDefault::parseList( const std::string& list, const std::string& name ) {
+  auto number = [&](std::string t) -> size_t {
+    boost::trim(t);
+    if(t=="max")
+      return std::max(1u, std::thread::hardware_concurrency());
+    // stoull accepts a sign and wraps negative numbers
+    if(t.empty() || !std::isdigit(static_cast<unsigned char>(t[0])))
+      throw po::error("invalid "+name+" '"+t+"'");
+    size_t pos = 0;
+    size_t v = std::stoull(t, &pos);
+    if(pos!=t.size())
+      throw po::error("invalid "+name+" '"+t+"'");
+    if(v==0)
+      throw po::error(name+" must be greater than 0");
+    return v;
+  };
+  std::vector<std::string> token;
+  std::vector<size_t> values;
+  boost::split(token, list, boost::is_any_of(","));
+  for( auto t : token ) {
+    boost::trim(t);
+    if(t.empty())
+      continue;
+    auto range = t.find("..");
+    if(range==std::string::npos) {
+      values.push_back(number(t));
+      continue;
+    }
+    std::string step = "+1";
+    auto colon = t.find(':', range);
+    if(colon!=std::string::npos) {
+      step = boost::trim_copy(t.substr(colon+1));
+      t = t.substr(0, colon);
+    }
+    size_t first = number(t.substr(0, range));
+    size_t last = number(t.substr(range+2));
+    size_t inc = step.size()>1 ? number(step.substr(1)) : 0;
+    bool mul = boost::starts_with(step, "x");
+    if( !(mul || boost::starts_with(step, "+")) || (mul && inc<2) )
+      throw po::error("invalid step '"+step+"' in "+name+" range");
+    for( size_t v=first; v<=last; ) {
+      values.push_back(v);
+      // stop instead of wrapping around at the end of size_t
+      if( mul ? v > last/inc : last-v < inc )
+        break;
+      v = mul ? v*inc : v+inc;
+    }
+  }
+  if(values.empty())
+    throw po::error("no "+name+" given");
+  return values;
+}
+
+void OptionsDefault::parseBatches( const std::string& batches ) {
+  batches_ = parseList(batches, "batch");
+}
+
+void OptionsDefault::parseStreams( const std::string& streams ) {
+  streams_ = parseList(streams, "streams");
+}
+
+void OptionsDefault::parseNumberDevices( const std::string& ndevices ) {
+  if(boost::trim_copy(ndevices)=="0")
+    ndevicesList_ = {0};
+  else
+    ndevicesList_ = parseList(ndevices, "ndevices");
+  ndevices_ = ndevicesList_.front();
+}
+
+void OptionsDefault::parseTargetCI( const std::string& target ) {
+  std::string t = boost::trim_copy(target);
+  targetCI_ = 0.0;
+  if(t.empty())
+    return;
+  bool percent = boost::ends_with(t, "%");
+  if(percent)
+    t.pop_back();
+  targetCI_ = std::stod(t);
+  if(percent)
+    targetCI_ /= 100.0;
+  if(targetCI_ < 0.0)
+    throw po::error("target-ci must not be negative");
+}
+
 /// processes command line arguments and apply the values to the variables
 int OptionsDefault::parse(std::vector<char*>& _argv, std::vector<char*>& _boost_vargv) {
 
@@ -104,6 +226,21 @@ int OptionsDefault::parse(std::vector<char*>& _argv, std::vector<char*>& _boost_
     }else{
       verbose_ = false;
     }
+    if( vm.count("steady-state")  ) {
+      steadyState_ = true;
+    }else{
+      steadyState_ = false;
+    }
+    if( vm.count("perf-counters")  ) {
+      perfCounters_ = true;
+    }else{
+      perfCounters_ = false;
+    }
+    ftz_ = vm.count("ftz") > 0;
+    memory_ = vm.count("memory") > 0;
+    osNoise_ = vm.count("os-noise") > 0;
+    trackAllocs_ = vm.count("track-allocs") > 0;
+    daz_ = vm.count("daz") > 0;
     if( vm.count("list-devices")  ) {
       listDevices_ = true;
       return 1;
@@ -141,6 +278,63 @@ int OptionsDefault::parse(std::vector<char*>& _argv, std::vector<char*>& _boost_
     }
 
     po::notify(vm);
+    parseBatches(batch_);
+    parseStreams(streamsStr_);
+    parseNumberDevices(ndevicesStr_);
+    // streams are independent single-threaded workers unless -n is given
+    if(isStreamsMode() && vm["ndevices"].defaulted())
+      parseNumberDevices("1");
+    if(!HugePages::isValidMode(hugePages_))
+      throw po::error("invalid hugepages mode '"+hugePages_+"'");
+    hugePagesReported_ = vm.count("hugepages") && !vm["hugepages"].defaulted();
+    if(timer_!="chrono" && timer_!="tsc")
+      throw po::error("invalid timer '"+timer_+"'");
+    if(!BufferRing::isValidSpec(bufferRing_))
+      throw po::error("invalid buffer-ring '"+bufferRing_+"'");
+    if(!Validation::isValid(validate_))
+      throw po::error("invalid validate policy '"+validate_+"'");
+    if(!DataPattern::isValid(data_))
+      throw po::error("invalid data '"+data_+"'");
+    if(noiseThreshold_ < 0.0)
+      throw po::error("noise-threshold must not be negative");
+    if(latencySamples_ > 0 && isStreamsMode())
+      throw po::error("latency cannot be combined with streams, the histograms are recorded per benchmark thread");
+    if(trackAllocs_ && isStreamsMode())
+      throw po::error("track-allocs cannot be combined with streams, the allocations are counted process-wide");
+    if(perfCounters_ && isStreamsMode()
+       && std::any_of(ndevicesList_.begin(), ndevicesList_.end(), [](size_t n) { return n != 1; }))
+      throw po::error("perf-counters with streams requires -n 1, the threads of the FFT library are shared by the streams");
+    if(innerTime_ < 0.0)
+      throw po::error("inner-time must not be negative");
+    if(innerTime_ > 0.0 && bufferRing_!="off")
+      throw po::error("inner-time repeats the transforms on cached data, it cannot be combined with buffer-ring");
+    if(!CpuPlacement::isValidPolicy(numaPolicy_))
+      throw po::error("invalid numa-policy '"+numaPolicy_+"'");
+    if(!CpuPlacement::isValidPin(pin_))
+      throw po::error("invalid pin '"+pin_+"'");
+    if(warmRuns_ < 1)
+      throw po::error("runs must be greater than 0");
+    if(warmups_ < 0)
+      throw po::error("warmups must not be negative");
+    if(latencySamples_ < 0 || latencySamples_ > MAX_LATENCY_SAMPLES)
+      throw po::error("latency must be between 0 and "+std::to_string(MAX_LATENCY_SAMPLES));
+    parseTargetCI(targetCIStr_);
+    if(maxRuns_ < 2)
+      throw po::error("max-runs must be greater than 1");
+    if(maxTime_ < 0.0)
+      throw po::error("max-time must not be negative");
+  }
+  catch(std::invalid_argument& e)
+  {
+    std::cerr << "ERROR: invalid number (" << e.what() << ")" << std::endl;
+    std::cerr << desc_ << std::endl;
+    return 2;
+  }
+  catch(std::out_of_range& e)
+  {
+    std::cerr << "ERROR: number out of range (" << e.what() << ")" << std::endl;
+    std::cerr << desc_ << std::endl;
+    return 2;
   }
   catch(po::error& e)
   {
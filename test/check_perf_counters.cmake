@@ -0,0 +1,67 @@
+# Runs a gearshifft binary with --perf-counters and checks that the counters of
+# the forward and inverse transforms are finite in every run (cycles positive).
+# Passes without checking if the counters cannot be opened (perf_event_paranoid, VMs).
+#
+# cmake -DBINARY=<gearshifft binary> -DOUTPUT=<csv file> -P check_perf_counters.cmake
+
+execute_process(COMMAND ${BINARY} -e 32 --perf-counters -o ${OUTPUT}
+  RESULT_VARIABLE result
+  ERROR_VARIABLE errors)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "${BINARY} failed (${result}):\n${errors}")
+endif()
+if(errors MATCHES "gearshifft: hardware counters not available")
+  message(STATUS "hardware counters not available, values not checked")
+  return()
+endif()
+# counters which could not be opened are nan, the others must count
+set(partial FALSE)
+if(errors MATCHES "some hardware counters not available")
+  set(partial TRUE)
+endif()
+
+file(STRINGS ${OUTPUT} lines)
+set(columns "")
+set(cycles "")
+set(nrows 0)
+foreach(line IN LISTS lines)
+  if(line MATCHES "^;")
+    continue()
+  endif()
+  string(REPLACE "\"" "" line "${line}")
+  string(REPLACE "," ";" fields "${line}")
+  if(NOT columns)
+    set(index 0)
+    foreach(field IN LISTS fields)
+      if(field MATCHES "^Perf_(FFT|iFFT)_")
+        list(APPEND columns ${index})
+      endif()
+      if(field MATCHES "^Perf_(FFT|iFFT)_Cycles")
+        list(APPEND cycles ${index})
+      endif()
+      math(EXPR index "${index}+1")
+    endforeach()
+    if(NOT columns)
+      message(FATAL_ERROR "no Perf_FFT_ columns in ${OUTPUT}")
+    endif()
+    continue()
+  endif()
+  set(finite 0)
+  foreach(index IN LISTS columns)
+    list(GET fields ${index} value)
+    list(FIND cycles ${index} is_cycles)
+    if(value MATCHES "^[0-9.e+-]+$" AND (is_cycles EQUAL -1 OR value GREATER 0))
+      math(EXPR finite "${finite}+1")
+    elseif(NOT partial)
+      message(FATAL_ERROR "counter column ${index} is '${value}' in:\n${line}")
+    endif()
+  endforeach()
+  if(finite EQUAL 0)
+    message(FATAL_ERROR "no counter counted in:\n${line}")
+  endif()
+  math(EXPR nrows "${nrows}+1")
+endforeach()
+if(nrows EQUAL 0)
+  message(FATAL_ERROR "no runs in ${OUTPUT}")
+endif()
+message(STATUS "${nrows} runs with finite counters")
@@ -0,0 +1,154 @@
+#define BOOST_TEST_MODULE TestBenchmarkData
+
+#include "core/benchmark_data.hpp"
+#include <boost/test/included/unit_test.hpp> // Single-header usage variant
+#include <array>
+#include <cstddef>
+#include <limits>
+
+using namespace gearshifft;
+
+namespace {
+
+  /// perturbs every 1000th element, element 7 is NaN if requested
+  template<typename TVector, typename TScale>
+  void perturb(TVector& vec, TScale scale, bool with_nan) {
+    for (size_t i = 0; i < vec.size(); ++i) {
+      vec[i] *= scale;
+      if (i % 1000 == 3)
+        vec[i] += scale * 0.01 * static_cast<double>(i % 7);
+    }
+    if (with_nan)
+      vec[7] = std::numeric_limits<double>::quiet_NaN();
+  }
+
+  template<bool Normalize, typename TData, typename TVector>
+  void compare(const TData& data, const TVector& vec, double error_bound) {
+    double deviation = 0.0, deviation_serial = 0.0;
+    size_t mismatches = 0, mismatches_serial = 0;
+    data.template check_deviation<Normalize>(deviation, mismatches, vec, error_bound);
+    data.template check_deviation_serial<Normalize>(deviation_serial, mismatches_serial, vec, error_bound);
+    BOOST_TEST( mismatches == mismatches_serial );
+    if (std::isnan(deviation_serial))
+      BOOST_TEST( std::isnan(deviation) );
+    else
+      BOOST_TEST( deviation == deviation_serial, boost::test_tools::tolerance(1e-10) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( CheckDeviationReal )
+{
+  using DataT = BenchmarkData<double, 1>;
+  const auto& data = DataT::data(std::array<size_t,1>{{ (1<<20) + 5 }});
+  DataT::RealVector vec;
+  data.copyTo(vec);
+  compare<false>(data, vec, 1e-5);
+  perturb(vec, 1.0, false);
+  compare<false>(data, vec, 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE( CheckDeviationNormalized )
+{
+  using DataT = BenchmarkData<float, 2>;
+  const auto& data = DataT::data(std::array<size_t,2>{{ 300, 301 }}, 3);
+  DataT::RealVector vec;
+  data.copyTo(vec);
+  perturb(vec, 300.0f * 301.0f, false);
+  compare<true>(data, vec, 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE( CheckDeviationComplexNaN )
+{
+  using DataT = BenchmarkData<double, 1>;
+  const auto& data = DataT::data(std::array<size_t,1>{{ 100000 }});
+  DataT::ComplexVector vec;
+  data.copyTo(vec);
+  perturb(vec, 1.0, true);
+  compare<false>(data, vec, 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE( CheckDeviationStrided )
+{
+  using DataT = BenchmarkData<double, 1>;
+  const auto& data = DataT::data(std::array<size_t,1>{{ 100003 }});
+  DataT::RealVector vec;
+  data.copyTo(vec);
+  perturb(vec, 1.0, false);
+  size_t expected = 0;
+  for (size_t i = 0; i < vec.size(); i += 3)
+    expected += i % 1000 == 3 && i % 7 != 0;
+  double deviation = 0.0;
+  size_t mismatches = 0;
+  data.check_deviation<false>(deviation, mismatches, vec, 1e-5, 3);
+  BOOST_TEST( mismatches == expected );
+  BOOST_TEST( std::isfinite(deviation) );
+
+  // stride >= total compares the first element only
+  const auto& small = DataT::data(std::array<size_t,1>{{ 16 }});
+  DataT::RealVector exact;
+  small.copyTo(exact);
+  for (size_t stride : {size_t(16), size_t(17), size_t(1000)}) {
+    deviation = -1.0;
+    mismatches = 0;
+    small.check_deviation<false>(deviation, mismatches, exact, 1e-5, stride);
+    BOOST_TEST( mismatches == 0u );
+    BOOST_TEST( deviation == 0.0 );
+  }
+  exact[0] += 0.5;
+  mismatches = 0;
+  small.check_deviation<false>(deviation, mismatches, exact, 1e-5, 16);
+  BOOST_TEST( mismatches == 1u );
+  BOOST_TEST( deviation == 0.5, boost::test_tools::tolerance(1e-12) );
+}
+
+BOOST_AUTO_TEST_CASE( CountNonFinite )
+{
+  using DataT = BenchmarkData<double, 1>;
+  const auto& data = DataT::data(std::array<size_t,1>{{ 10000 }});
+  DataT::ComplexVector vec;
+  data.copyTo(vec);
+  BOOST_TEST( data.count_nonfinite(vec) == 0u );
+  vec[7] = std::numeric_limits<double>::quiet_NaN();
+  vec[9000] = std::numeric_limits<double>::infinity();
+  BOOST_TEST( data.count_nonfinite(vec) == 2u );
+}
+
+BOOST_AUTO_TEST_CASE( CopyToRestoresInput )
+{
+  using DataT = BenchmarkData<float, 1>;
+  const auto& data = DataT::data(std::array<size_t,1>{{ 3*DataT::COPY_CHUNK + 11 }});
+  DataT::ComplexVector vec;
+  data.copyTo(vec);
+  perturb(vec, 2.0f, true);
+  data.copyTo(vec);
+  double deviation = 0.0;
+  size_t mismatches = 0;
+  data.check_deviation<false>(deviation, mismatches, vec, 0.0);
+  BOOST_TEST( mismatches == 0u );
+  BOOST_TEST( deviation == 0.0 );
+  for (size_t i = 0; i < vec.size(); i += 1001)
+    BOOST_TEST( vec[i].imag() == 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( DataPatternsReproducible )
+{
+  using DataT = BenchmarkData<double, 1>;
+  DataPattern::configure("gaussian", 42);
+  DataT::RealVector first, second;
+  DataT::data(std::array<size_t,1>{{ 2*DataT::COPY_CHUNK + 3 }}).copyTo(first);
+  DataT::data(std::array<size_t,1>{{ 17 }});
+  DataT::data(std::array<size_t,1>{{ 2*DataT::COPY_CHUNK + 3 }}).copyTo(second);
+  BOOST_TEST( first == second );
+  DataPattern::configure("sawtooth", 0);
+}
+
+BOOST_AUTO_TEST_CASE( DataPatternDenormalHeavy )
+{
+  using DataT = BenchmarkData<float, 1>;
+  DataPattern::configure("denormal-heavy", 0);
+  DataT::RealVector vec;
+  DataT::data(std::array<size_t,1>{{ 1000 }}).copyTo(vec);
+  for (size_t i = 0; i < vec.size(); ++i)
+    BOOST_TEST( (std::fpclassify(vec[i]) == ((i&7) ? FP_SUBNORMAL : FP_ZERO)) );
+  DataPattern::configure("sawtooth", 0);
+}
@@ -0,0 +1,77 @@
+#define BOOST_TEST_MODULE TestLatencyHistogram
+
+#include "core/latency_histogram.hpp"
+#include <boost/test/included/unit_test.hpp> // Single-header usage variant
+#include <cstdint>
+#include <limits>
+
+using namespace gearshifft;
+
+namespace {
+
+  void check_bucket(uint64_t v) {
+    size_t i = LatencyHistogram::index(v);
+    BOOST_TEST( i < LatencyHistogram::NR_BUCKETS );
+    BOOST_TEST( LatencyHistogram::lower(i) <= v );
+    BOOST_TEST( v <= LatencyHistogram::upper(i) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( BucketBounds )
+{
+  for(uint64_t v = 0; v < 300; ++v)
+    check_bucket(v);
+  BOOST_TEST( LatencyHistogram::index(127) == 127u );
+  BOOST_TEST( LatencyHistogram::index(128) == 128u );
+  for(unsigned k = LatencyHistogram::SUB_BITS; k < 64; ++k) {
+    const uint64_t p = uint64_t(1) << k;
+    check_bucket(p - 1);
+    check_bucket(p);
+    check_bucket(p + 1);
+    BOOST_TEST( LatencyHistogram::lower(LatencyHistogram::index(p)) == p );
+    BOOST_TEST( LatencyHistogram::upper(LatencyHistogram::index(p - 1)) == p - 1 );
+  }
+  const uint64_t max = std::numeric_limits<uint64_t>::max();
+  check_bucket(max);
+  BOOST_TEST( LatencyHistogram::index(max) == 3775u );
+  BOOST_TEST( LatencyHistogram::index(max) == LatencyHistogram::NR_BUCKETS - 1 );
+  BOOST_TEST( LatencyHistogram::upper(LatencyHistogram::NR_BUCKETS - 1) == max );
+}
+
+BOOST_AUTO_TEST_CASE( BucketWidth )
+{
+  // buckets are exact below 2^SUB_BITS, above the relative width is at most 2^(1-SUB_BITS)
+  for(size_t i = 0; i < LatencyHistogram::SUB_COUNT; ++i)
+    BOOST_TEST( LatencyHistogram::lower(i) == LatencyHistogram::upper(i) );
+  const double bound = 1.0 / static_cast<double>(LatencyHistogram::HALF_COUNT);
+  for(size_t i = LatencyHistogram::SUB_COUNT; i < LatencyHistogram::NR_BUCKETS; ++i) {
+    const uint64_t width = LatencyHistogram::upper(i) - LatencyHistogram::lower(i) + 1;
+    BOOST_TEST( static_cast<double>(width) / static_cast<double>(LatencyHistogram::lower(i)) <= bound );
+    if(i + 1 < LatencyHistogram::NR_BUCKETS) // buckets are contiguous
+      BOOST_TEST( LatencyHistogram::upper(i) + 1 == LatencyHistogram::lower(i + 1) );
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Percentiles )
+{
+  LatencyHistogram hist;
+  BOOST_TEST( hist.percentile(0.5) == 0u );
+  for(uint64_t v = 1; v <= 100; ++v)
+    hist.record(v);
+  BOOST_TEST( hist.count() == 100u );
+  BOOST_TEST( hist.percentile(0.5) == 50u );
+  BOOST_TEST( hist.percentile(0.99) == 99u );
+  BOOST_TEST( hist.percentile(1.0) == 100u );
+  BOOST_TEST( hist.percentile(0.001) == 1u );
+
+  // 1000..1999 ns, above 2^SUB_BITS the percentile is the upper end of its bucket
+  hist.clear();
+  for(uint64_t v = 1000; v < 2000; ++v)
+    hist.record(v);
+  BOOST_TEST( hist.max() == 1999u );
+  const uint64_t p50 = hist.percentile(0.5);
+  BOOST_TEST( p50 >= 1499u );
+  BOOST_TEST( p50 == LatencyHistogram::upper(LatencyHistogram::index(1499)) );
+  BOOST_TEST( hist.percentile(0.999) <= 1999u );
+  BOOST_TEST( hist.percentile(1.0) == 1999u );
+}
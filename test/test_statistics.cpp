@@ -0,0 +1,100 @@
+#define BOOST_TEST_MODULE TestStatistics
+
+#include "core/statistics.hpp"
+#include <boost/test/included/unit_test.hpp> // Single-header usage variant
+#include <cmath>
+#include <limits>
+
+using namespace gearshifft;
+
+BOOST_AUTO_TEST_CASE( StudentT95 )
+{
+  BOOST_TEST( studentT95(0) == std::numeric_limits<double>::infinity() );
+  BOOST_TEST( studentT95(1) == 12.706 );
+  BOOST_TEST( studentT95(30) == 2.042 );
+  // Cornish-Fisher expansion beyond the table, t(31) = 2.0395
+  BOOST_TEST( studentT95(31) == 2.0395, boost::test_tools::tolerance(1e-4) );
+  BOOST_TEST( studentT95(31) < studentT95(30) );
+  BOOST_TEST( studentT95(1000) == 1.9623, boost::test_tools::tolerance(1e-4) );
+}
+
+BOOST_AUTO_TEST_CASE( RunningStatsWelford )
+{
+  RunningStats stats;
+  BOOST_TEST( stats.variance() == 0.0 );
+  BOOST_TEST( stats.relativeCI() == std::numeric_limits<double>::infinity() );
+  for(double x : {2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0})
+    stats.add(x);
+  BOOST_TEST( stats.count() == 8u );
+  BOOST_TEST( stats.mean() == 5.0, boost::test_tools::tolerance(1e-12) );
+  BOOST_TEST( stats.variance() == 32.0/7.0, boost::test_tools::tolerance(1e-12) );
+  BOOST_TEST( stats.relativeCI() == 2.365*std::sqrt(32.0/7.0/8.0)/5.0,
+              boost::test_tools::tolerance(1e-12) );
+  stats.clear();
+  stats.add(0.0);
+  stats.add(0.0);
+  BOOST_TEST( stats.relativeCI() == std::numeric_limits<double>::infinity() );
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveWarmupAndTarget )
+{
+  AdaptiveRepetition repetition(0.01, 100, 0.0);
+  BOOST_TEST( repetition.next(10.0, 10.0) );
+  BOOST_TEST( repetition.next(5.0, 5.0) );  // half the time of the previous run
+  BOOST_TEST( repetition.next(5.0, 5.5) );  // within 10%, warmup is over
+  BOOST_TEST( repetition.getNumberWarmups() == 3 );
+  BOOST_TEST( repetition.next(5.0, 5.0) );
+  BOOST_TEST( repetition.next(5.0, 5.0) );  // MIN_RUNS not reached
+  BOOST_TEST( !repetition.next(5.0, 5.0) ); // confidence interval 0
+  BOOST_TEST( repetition.getNumberRuns() == 6 );
+  BOOST_TEST( repetition.getNumberWarmups() == 3 );
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveTargetCI )
+{
+  // relative confidence interval of 1.00, 1.01, 0.99 is 2.5%
+  const double times[] = {1.0, 1.0, 1.01, 0.99, 1.0, 1.01, 0.99};
+  AdaptiveRepetition loose(0.05, 100, 0.0);
+  AdaptiveRepetition tight(0.01, 100, 0.0);
+  for(size_t i = 0; i < 4; ++i) {
+    BOOST_TEST( loose.next(times[i], times[i]) );
+    BOOST_TEST( tight.next(times[i], times[i]) );
+  }
+  BOOST_TEST( !loose.next(times[4], times[4]) );
+  BOOST_TEST( loose.getNumberRuns() == 5 );
+  BOOST_TEST( loose.getNumberWarmups() == 2 );
+  BOOST_TEST( tight.next(times[4], times[4]) );
+  BOOST_TEST( tight.next(times[5], times[5]) );
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveMaxRuns )
+{
+  // alternating times never finish the warmup, at most half of the runs are warmups
+  AdaptiveRepetition repetition(0.01, 10, 0.0);
+  for(int i = 1; i < 10; ++i)
+    BOOST_TEST( repetition.next(i%2 ? 1.0 : 3.0, 1.0) );
+  BOOST_TEST( repetition.getNumberWarmups() == 5 );
+  BOOST_TEST( !repetition.next(3.0, 1.0) );
+  BOOST_TEST( repetition.getNumberRuns() == 10 );
+  BOOST_TEST( repetition.getNumberWarmups() == 5 );
+}
+
+BOOST_AUTO_TEST_CASE( AdaptiveOnlyWarmups )
+{
+  // the last run is kept as measurement if all runs were warmups
+  AdaptiveRepetition repetition(0.01, 1, 0.0);
+  BOOST_TEST( !repetition.next(1.0, 1.0) );
+  BOOST_TEST( repetition.getNumberRuns() == 1 );
+  BOOST_TEST( repetition.getNumberWarmups() == 0 );
+}
+
+BOOST_AUTO_TEST_CASE( BreakEven )
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  // 100 ms more planning, 0.5 ms less per execution
+  BOOST_TEST( breakEven(1.0, 2.0, 101.0, 1.5) == 200.0 );
+  BOOST_TEST( breakEven(1.0, 2.0, 1.0, 1.5) == 0.0 );
+  BOOST_TEST( breakEven(1.0, 2.0, 101.0, 2.0) == inf );
+  BOOST_TEST( breakEven(1.0, 2.0, 101.0, 2.5) == inf );
+  BOOST_TEST( breakEven(1.0, 2.0, 1.0, 2.0) == 0.0 );
+}